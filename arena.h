@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+#include <type_traits>
+
+/*
+    Bump allocator owning every node of a parsed document.
+    Objects are laid out contiguously in large blocks in creation order and are destroyed
+    in reverse order when the arena is released, all the memory is returned in one shot.
+*/
+struct Arena
+{
+    static const size_t block_size = 64 * 1024;
+
+    Arena() { }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() { release(); }
+
+    void* allocate(size_t size,size_t alignment)
+    {
+        size_t offset = (alignment - reinterpret_cast<size_t>(cursor) % alignment) % alignment;
+        if (cursor == nullptr || cursor + offset + size > end)
+        {
+            size_t capacity = size + alignment > block_size ? size + alignment : block_size;
+            char* block = static_cast<char*>(std::malloc(capacity));
+            if (block == nullptr) throw std::bad_alloc();
+            blocks.push_back(block);
+            cursor = block;
+            end = block + capacity;
+            offset = (alignment - reinterpret_cast<size_t>(cursor) % alignment) % alignment;
+        }
+        void* result = cursor + offset;
+        cursor += offset + size;
+        used += size;
+        return result;
+    }
+
+    template <typename T,typename ... Args>
+    T* make(Args&& ... args)
+    {
+        T* object = new (allocate(sizeof(T),alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value)
+        {
+            Destructor* d = new (allocate(sizeof(Destructor),alignof(Destructor))) Destructor;
+            d->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+            d->object = object;
+            d->next = destructors;
+            destructors = d;
+        }
+        return object;
+    }
+
+    void release()
+    {
+        for (Destructor* d = destructors; d != nullptr; d = d->next) d->destroy(d->object);
+        destructors = nullptr;
+        for (char* block : blocks) std::free(block);
+        blocks.clear();
+        cursor = end = nullptr;
+        used = 0;
+    }
+
+    size_t bytes_used() const { return used; }
+
+    private:
+
+    struct Destructor
+    {
+        void (*destroy)(void*);
+        void* object;
+        Destructor* next;
+    };
+
+    std::vector<char*> blocks;
+    char* cursor = nullptr;
+    char* end = nullptr;
+    Destructor* destructors = nullptr;
+    size_t used = 0;
+};
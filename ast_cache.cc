@@ -0,0 +1,269 @@
+#include "ast_cache.h"
+#include "expression_types.h"
+#include "mapped_file.h"
+#include <cstring>
+#include <cstdio>
+
+static const char ast_magic[4] = {'E','X','P','A'};
+static const uint32_t ast_version = 2;      //Bumped whenever the encoding of a node changes
+
+struct AstHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t hash;
+    uint64_t size;                      //Of the source text
+};
+
+//FNV-1a
+uint64_t content_hash(const char* data,size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string ast_cache_path(const std::string& directory,uint64_t hash)
+{
+    char name[32];
+    std::snprintf(name,sizeof(name),"/%016llx.ast",static_cast<unsigned long long>(hash));
+    return directory + name;
+}
+
+struct AstWriter
+{
+    std::string out;
+
+    template <typename T>
+    void put(T value) { out.append(reinterpret_cast<const char*>(&value),sizeof(T)); }
+
+    void put_text(const std::string& text)
+    {
+        put<uint32_t>(text.size());
+        out += text;
+    }
+
+    void put_span(const SourceSpan& span)
+    {
+        put<uint32_t>(span.line);
+        put<uint32_t>(span.column);
+        put<uint32_t>(span.endLine);
+        put<uint32_t>(span.endColumn);
+    }
+
+    void write(Expression* expression)
+    {
+        put<uint8_t>(expression->getType());
+        put_span(expression->span);
+        switch(expression->getType())
+        {
+            //Constants of the parser are numbers
+            case ex_Constant: put<double>(static_cast<Constant*>(expression)->v[0]); return;
+            case ex_StringConstant: put_text(static_cast<StringConstant*>(expression)->str.as_string()); return;
+            case ex_Variable: put_text(static_cast<Variable*>(expression)->name); return;
+            case ex_Operation: put<uint8_t>(static_cast<Operation*>(expression)->op_type); break;
+            case ex_Vector:
+            case ex_ExpressionBlock: put<uint32_t>(expression->dependencies.size()); break;
+            case ex_Assignment:
+            case ex_ReturnExpression:
+            case ex_Function:
+            case ex_FunctionCall: break;
+            default: throw std::runtime_error("Cache: the tree is not a parsed document");
+        }
+        for (Expression* e : expression->dependencies) write(e);
+    }
+};
+
+struct AstReader
+{
+    Scope& scope;
+    const char* cursor;
+    const char* end;
+    bool ok = true;
+
+    AstReader(Scope& _scope,const char* _cursor,const char* _end) : scope(_scope), cursor(_cursor), end(_end) { }
+
+    template <typename T>
+    T get()
+    {
+        T value{};
+        if (end - cursor < (ptrdiff_t)sizeof(T)) { ok = false; return value; }
+        std::memcpy(&value,cursor,sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    std::string_view get_text()
+    {
+        uint32_t size = get<uint32_t>();
+        if (!ok || end - cursor < (ptrdiff_t)size) { ok = false; return std::string_view(); }
+        std::string_view text(cursor,size);
+        cursor += size;
+        return text;
+    }
+
+    template <typename T,typename ... Args>
+    T* make(Args&& ... args) { return scope.arena.make<T>(std::forward<Args>(args)...); }
+
+    //Children are checked to be what their parent casts them to
+    template <typename T>
+    T* read_as(ExpressionType type)
+    {
+        Expression* expression = read();
+        if (expression == nullptr || expression->getType() != type) { ok = false; return nullptr; }
+        return static_cast<T*>(expression);
+    }
+
+    Expression* read()
+    {
+        uint8_t type = get<uint8_t>();
+        SourceSpan span;
+        span.line = get<uint32_t>();
+        span.column = get<uint32_t>();
+        span.endLine = get<uint32_t>();
+        span.endColumn = get<uint32_t>();
+        if (!ok) return nullptr;
+        Expression* expression = read_node(type);
+        if (expression) expression->span = span;
+        return expression;
+    }
+
+    Expression* read_node(uint8_t type)
+    {
+        switch(type)
+        {
+            case ex_Constant:
+            {
+                double v = get<double>();
+                return ok ? make<Constant>(Value(v)) : nullptr;
+            }
+            case ex_StringConstant:
+            {
+                std::string_view text = get_text();
+                return ok ? make<StringConstant>(scope,Value(std::string(text))) : nullptr;
+            }
+            case ex_Variable:
+            {
+                std::string_view name = get_text();
+                return ok ? make<Variable>(scope.symbols,name) : nullptr;
+            }
+            case ex_Assignment:
+            {
+                Variable* identifier = read_as<Variable>(ex_Variable);
+                Expression* value = ok ? read() : nullptr;
+                return ok && value ? make<Assignment>(identifier,value) : nullptr;
+            }
+            case ex_Vector:
+            {
+                uint32_t size = get<uint32_t>();
+                Vector* vector = make<Vector>();
+                for (uint32_t i = 0; ok && i < size; i++)
+                {
+                    Expression* e = read();
+                    if (e) vector->add_expression(e);
+                }
+                return ok ? vector : nullptr;
+            }
+            case ex_Operation:
+            {
+                uint8_t op = get<uint8_t>();
+                Expression* a = ok ? read() : nullptr;
+                Expression* b = ok ? read() : nullptr;
+                return ok && op <= op_ref && a && b ? make<Operation>(a,b,static_cast<OperationType>(op)) : nullptr;
+            }
+            case ex_ReturnExpression:
+            {
+                Expression* value = read();
+                return ok && value ? make<ReturnExpression>(value) : nullptr;
+            }
+            case ex_ExpressionBlock:
+            {
+                uint32_t size = get<uint32_t>();
+                ExpressionBlock* block = make<ExpressionBlock>();
+                for (uint32_t i = 0; ok && i < size; i++)
+                {
+                    Expression* e = read();
+                    if (e) block->add_expression(e);
+                }
+                return ok ? block : nullptr;
+            }
+            case ex_Function:
+            {
+                Vector* parameters = read_as<Vector>(ex_Vector);
+                ExpressionBlock* body = ok ? read_as<ExpressionBlock>(ex_ExpressionBlock) : nullptr;
+                return ok ? make<Function>(parameters,body) : nullptr;
+            }
+            case ex_FunctionCall:
+            {
+                Variable* identifier = read_as<Variable>(ex_Variable);
+                Vector* arguments = ok ? read_as<Vector>(ex_Vector) : nullptr;
+                return ok ? make<FunctionCall>(identifier,arguments) : nullptr;
+            }
+            default:
+                ok = false;
+                return nullptr;
+        }
+    }
+};
+
+std::string encode_ast(uint64_t hash,size_t size,Expression* root)
+{
+    AstHeader header;
+    std::memcpy(header.magic,ast_magic,sizeof(ast_magic));
+    header.version = ast_version;
+    header.hash = hash;
+    header.size = size;
+
+    AstWriter writer;
+    writer.put(header);
+    writer.write(root);
+    return std::move(writer.out);
+}
+
+Expression* decode_ast(const char* data,size_t length,uint64_t hash,size_t size,Scope& scope)
+{
+    AstHeader header;
+    if (length < sizeof(header)) return nullptr;
+    std::memcpy(&header,data,sizeof(header));
+    if (std::memcmp(header.magic,ast_magic,sizeof(ast_magic)) != 0 || header.version != ast_version) return nullptr;
+    if (header.hash != hash || header.size != size) return nullptr;
+
+    AstReader reader(scope,data + sizeof(header),data + length);
+    Expression* root = reader.read();
+    return reader.ok && reader.cursor == reader.end ? root : nullptr;
+}
+
+void store_ast(const std::string& path,uint64_t hash,size_t size,Expression* root)
+{
+    std::string tree = encode_ast(hash,size,root);
+
+    //The cache only saves time, a directory that cannot be written is left alone
+    std::string directory = path.substr(0,path.rfind('/'));
+    if (!directory.empty()) ::mkdir(directory.c_str(),0755);
+    std::string temporary = path + "." + std::to_string(::getpid()) + ".tmp";
+    int fd = ::open(temporary.c_str(),O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,0644);
+    if (fd < 0) return;
+    const char* data = tree.data();
+    size_t left = tree.size();
+    while (left > 0)
+    {
+        ssize_t n = ::write(fd,data,left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        data += n;
+        left -= n;
+    }
+    bool written = ::close(fd) == 0 && left == 0;
+    if (!written || std::rename(temporary.c_str(),path.c_str()) != 0) ::unlink(temporary.c_str());
+}
+
+Expression* load_ast(const std::string& path,uint64_t hash,size_t size,Scope& scope)
+{
+    if (::access(path.c_str(),R_OK) != 0) return nullptr;
+    MappedFile file(path);
+    return decode_ast(file.data(),file.size(),hash,size,scope);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct Scope;
+struct Expression;
+
+/*
+    On disk cache of parsed documents, keyed by a hash of their text.
+    A document is stored as its tree in preorder, every node as its type, its literal data
+    and its children, and is loaded with a single mapping of the file through the same
+    constructors the parser uses. Name resolution and optimization run again on the
+    loaded tree: they only depend on the tree and cost far less than lexing and parsing.
+    EXPRESS_CACHE=<directory> enables the cache for parse_file(), see Scope::cacheDirectory.
+*/
+
+uint64_t content_hash(const char* data,size_t size);
+
+std::string ast_cache_path(const std::string& directory,uint64_t hash);
+
+//Stored form of a parsed tree, and the tree built back from it in the arena of scope (nullptr when it does not match)
+std::string encode_ast(uint64_t hash,size_t size,Expression* root);
+Expression* decode_ast(const char* data,size_t length,uint64_t hash,size_t size,Scope& scope);
+
+//The file is written aside and renamed, concurrent writers of the same document are harmless
+void store_ast(const std::string& path,uint64_t hash,size_t size,Expression* root);
+
+//Builds a stored tree in the arena of scope, nullptr when the file is missing, stale or damaged
+Expression* load_ast(const std::string& path,uint64_t hash,size_t size,Scope& scope);
@@ -0,0 +1,320 @@
+#include "batch.h"
+#include "expression_types.h"
+
+//What a value looks like in every binding, ordered so that the join of two shapes is the largest
+enum Shape { sh_scalar, sh_any, sh_column };
+
+/*
+    Decides whether evaluating the document with every input bound to its whole column
+    gives, element by element, the result of each binding. It holds when values that
+    depend on an input (columns) only meet scalars, and only through element wise
+    operations and scalar builtins: vector literals keep the first element of their
+    components, indexing and reductions mix the bindings up.
+*/
+struct ShapeAnalysis
+{
+    using Names = std::map<int,Shape>;
+
+    bool vectorizable = true;
+    Names globals;
+    std::vector<Names*> chain;          //Names visible from the block being analyzed, innermost last
+    std::map<int,Function*> functions;  //Document level names defined once as a function
+    std::vector<Function*> open;        //Functions being analyzed
+    bool changed = false;
+
+    Shape join(Shape a,Shape b)
+    {
+        if ((a == sh_any && b == sh_column) || (a == sh_column && b == sh_any)) vectorizable = false;
+        return std::max(a,b);
+    }
+
+    void define(Names& names,int symbol,Shape shape)
+    {
+        auto it = names.find(symbol);
+        Shape joined = it == names.end() ? shape : join(it->second,shape);
+        if (it == names.end() || it->second != joined) changed = true;
+        names[symbol] = joined;
+    }
+
+    Shape lookup(int symbol)
+    {
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            auto found = (*it)->find(symbol);
+            if (found != (*it)->end()) return found->second;
+        }
+        const Builtins& builtins = Builtins::get();
+        auto found = builtins.layout.find(symbol);
+        if (found != builtins.layout.end() && builtins.slots[found->second].expression->getType() == ex_Constant) return sh_scalar;
+        return sh_any;
+    }
+
+    //Statements are repeated until the names they assign are stable, as assignments are lazy
+    Shape block(const std::vector<Expression*>& statements,Names& names)
+    {
+        chain.push_back(&names);
+        Shape result = sh_any;
+        bool outer = changed;
+        do
+        {
+            changed = false;
+            for (Expression* statement : statements)
+            {
+                result = analyze(statement);
+                if (statement->getType() == ex_ReturnExpression) break;
+            }
+        }
+        while (changed);
+        changed = outer;
+        chain.pop_back();
+        return result;
+    }
+
+    Shape call(FunctionCall* call)
+    {
+        std::vector<Shape> arguments;
+        for (Expression* argument : call->valueVector->variables) arguments.push_back(analyze(argument));
+        bool varies = std::find(arguments.begin(),arguments.end(),sh_column) != arguments.end();
+
+        int symbol = call->functionIdentifier->symbol;
+        bool local = false;
+        for (size_t i = 1; i < chain.size(); i++) local |= chain[i]->count(symbol) > 0;
+
+        const Builtins& builtins = Builtins::get();
+        auto builtin = builtins.layout.find(symbol);
+        if (!local && globals.count(symbol) == 0 && functions.count(symbol) == 0 && builtin != builtins.layout.end())
+        {
+            Expression* expression = builtins.slots[builtin->second].expression;
+            if (expression->getType() != ex_InternalFunction || static_cast<InternalFunction*>(expression)->is_expression_function())
+            {
+                vectorizable &= !varies;
+                return sh_any;
+            }
+            if (static_cast<InternalFunction*>(expression)->functionPtr.type == fn_vector)
+            {
+                vectorizable &= !varies;
+                return sh_scalar;
+            }
+            return arguments.empty() ? sh_any : arguments[0];
+        }
+
+        auto found = functions.find(symbol);
+        if (local || found == functions.end() || std::find(open.begin(),open.end(),found->second) != open.end())
+        {
+            vectorizable &= !varies;
+            return sh_any;
+        }
+
+        //Arguments are thunks of the caller, the body only sees the names of the document and its own
+        Function* function = found->second;
+        Names locals;
+        std::vector<Expression*>& parameters = function->parameterVector->variables;
+        for (size_t i = 0; i < parameters.size() && i < arguments.size(); i++) locals[static_cast<Variable*>(parameters[i])->symbol] = arguments[i];
+        std::vector<Names*> caller;
+        caller.swap(chain);
+        chain.push_back(&globals);
+        open.push_back(function);
+        Shape result = block(function->expressionBlock->expressions,locals);
+        open.pop_back();
+        chain.swap(caller);
+        return result;
+    }
+
+    Shape analyze(Expression* expression)
+    {
+        switch(expression->getType())
+        {
+            case ex_Constant: return static_cast<Constant*>(expression)->v.size() == 1 ? sh_scalar : sh_any;
+            case ex_Variable: return lookup(static_cast<Variable*>(expression)->symbol);
+            case ex_Function: return sh_any;
+            case ex_Assignment:
+            {
+                Assignment* assignment = static_cast<Assignment*>(expression);
+                Shape shape = analyze(assignment->assignment);
+                define(*chain.back(),assignment->identifier->symbol,shape);
+                return shape;
+            }
+            case ex_Vector:
+            {
+                Vector* vector = static_cast<Vector*>(expression);
+                if (vector->size() == 1) return analyze(vector->at(0));
+                for (Expression* e : vector->variables) vectorizable &= analyze(e) != sh_column;
+                return sh_any;
+            }
+            case ex_Operation:
+            {
+                Operation* operation = static_cast<Operation*>(expression);
+                Shape a = analyze(operation->a);
+                Shape b = analyze(operation->b);
+                if (operation->op_type == op_ref)
+                {
+                    vectorizable &= a != sh_column && b != sh_column;
+                    return sh_scalar;
+                }
+                return join(a,b);
+            }
+            case ex_FunctionCall: return call(static_cast<FunctionCall*>(expression));
+            case ex_ReturnExpression: return analyze(static_cast<ReturnExpression*>(expression)->returnValue);
+            case ex_ExpressionBlock:
+            {
+                Names locals;
+                return block(static_cast<ExpressionBlock*>(expression)->expressions,locals);
+            }
+            default:
+                //Strings interpolate names by their text
+                vectorizable = false;
+                return sh_any;
+        }
+    }
+};
+
+//The statements of the document in evaluation order
+static std::vector<Expression*> document_statements(Expression* root)
+{
+    if (root->getType() == ex_ExpressionBlock) return static_cast<ExpressionBlock*>(root)->expressions;
+    return {root};
+}
+
+//Cached results of pure functions may depend on the inputs
+static void clear_memo(Scope& scope)
+{
+    for (Function* function : scope.pureFunctions)
+    {
+        delete function->cache;
+        function->cache = nullptr;
+    }
+}
+
+BatchEvaluator::BatchEvaluator(Scope& _scope,const std::vector<std::string>& names) : scope(_scope)
+{
+    std::vector<Expression*> statements = document_statements(scope.rootExpression);
+    if (statements.empty()) throw std::runtime_error("Batch: the document is empty");
+    ShapeAnalysis analysis;
+
+    for (const std::string& name : names)
+    {
+        int symbol = scope.symbols.intern(name);
+        Assignment* target = nullptr;
+        for (Expression* statement : statements)
+        {
+            if (statement->getType() != ex_Assignment) continue;
+            Assignment* assignment = static_cast<Assignment*>(statement);
+            if (assignment->identifier->symbol == symbol) { target = assignment; break; }
+        }
+        if (target == nullptr) throw std::runtime_error("Batch: " + name + " is not assigned at document level");
+
+        Constant* input = scope.arena.make<Constant>(Value(0.0));
+        std::replace(target->dependencies.begin(),target->dependencies.end(),target->assignment,static_cast<Expression*>(input));
+        target->assignment = input;
+        target->identifier->represents_vector = false;
+        inputs.push_back(input);
+        analysis.globals[symbol] = sh_column;
+    }
+
+    std::map<int,int> definitions;
+    for (Expression* statement : statements)
+    {
+        if (statement->getType() != ex_Assignment) continue;
+        Assignment* assignment = static_cast<Assignment*>(statement);
+        int symbol = assignment->identifier->symbol;
+        definitions[symbol]++;
+        if (assignment->assignment->getType() == ex_Function) analysis.functions[symbol] = static_cast<Function*>(assignment->assignment);
+    }
+    for (auto& definition : definitions) if (definition.second > 1) analysis.functions.erase(definition.first);
+
+    //The result is the first return or the last statement, a vector literal gives one column per component
+    size_t last = statements.size() - 1;
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        if (statements[i]->getType() == ex_ReturnExpression) { last = i; break; }
+    }
+    prefix.assign(statements.begin(),statements.begin() + last);
+    Expression* result = statements[last];
+    if (result->getType() == ex_ReturnExpression) result = static_cast<ReturnExpression*>(result)->returnValue;
+
+    if (result->getType() == ex_Vector && static_cast<Vector*>(result)->size() > 1) outputs = static_cast<Vector*>(result)->variables;
+    else outputs.push_back(result);
+
+    analysis.block(prefix,analysis.globals);
+    analysis.chain.push_back(&analysis.globals);
+    for (Expression* output : outputs)
+    {
+        Shape shape = analysis.analyze(output);
+        varying.push_back(shape == sh_column);
+        //A single result that is not a number per binding does not fit a column
+        if (outputs.size() == 1 && shape == sh_any) analysis.vectorizable = false;
+    }
+    analysis.chain.pop_back();
+    vectorized = analysis.vectorizable;
+}
+
+BatchEvaluator::Columns BatchEvaluator::evaluate(const Columns& columns)
+{
+    if (columns.size() != inputs.size()) throw std::runtime_error("Batch: expected a column per input");
+    size_t n = columns.empty() ? 1 : columns[0].size();
+    for (const std::vector<double>& column : columns)
+    {
+        if (column.size() != n) throw std::runtime_error("Batch: columns of different length");
+    }
+
+    clear_memo(scope);
+    if (n == 0) return Columns();
+    return vectorized ? evaluate_vectorized(columns,n) : evaluate_sequential(columns,n);
+}
+
+BatchEvaluator::Columns BatchEvaluator::evaluate_vectorized(const Columns& columns,size_t n)
+{
+    for (size_t i = 0; i < inputs.size(); i++) inputs[i]->v = Value(columns[i]);
+
+    FrameSwitch frame(scope,scope.global);
+    scope.eliminateCommon = true;
+    Columns result;
+    try
+    {
+        //Same order as the block of the document, assignments stay thunks until they are read
+        for (Expression* statement : prefix)
+        {
+            if (statement->getType() == ex_Assignment) static_cast<Assignment*>(statement)->bind(scope);
+            else statement->evaluate(scope);
+        }
+        for (size_t j = 0; j < outputs.size(); j++)
+        {
+            parallel_force(scope,outputs[j]);
+            Value v = outputs[j]->evaluate(scope);
+            if (v.is_string()) throw std::runtime_error("Batch: the result is not numeric");
+            if (varying[j])
+            {
+                if (v.size() != n && v.size() != 1) throw std::runtime_error("Batch: result does not match the batch");
+                std::vector<double> column(n);
+                for (size_t k = 0; k < n; k++) column[k] = v[k];
+                result.push_back(std::move(column));
+            }
+            //Results that do not depend on the inputs are repeated for each binding
+            else if (outputs.size() > 1) result.push_back(std::vector<double>(n,v.empty() ? 0.0 : v[0]));
+            else for (double d : v) result.push_back(std::vector<double>(n,d));
+        }
+    }
+    catch (...)
+    {
+        scope.eliminateCommon = false;
+        throw;
+    }
+    scope.eliminateCommon = false;
+    return result;
+}
+
+BatchEvaluator::Columns BatchEvaluator::evaluate_sequential(const Columns& columns,size_t n)
+{
+    Columns result;
+    for (size_t k = 0; k < n; k++)
+    {
+        for (size_t i = 0; i < inputs.size(); i++) inputs[i]->v = Value(columns[i][k]);
+        if (k) clear_memo(scope);
+        Value v = scope.evaluate();
+        if (v.is_string()) throw std::runtime_error("Batch: the result is not numeric");
+        if (k == 0) result.assign(v.size(),std::vector<double>(n));
+        if (v.size() != result.size()) throw std::runtime_error("Batch: bindings give results of different size");
+        for (size_t j = 0; j < v.size(); j++) result[j][k] = v[j];
+    }
+    return result;
+}
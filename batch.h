@@ -0,0 +1,37 @@
+#pragma once
+#include "scope.h"
+
+struct Constant;
+
+/*
+    Evaluation of one parsed document over many bindings of its inputs.
+    Inputs are top level assignments whose value is replaced by every binding, bindings
+    are given as columns (one per input, one number per binding) and results come back
+    the same way, one column per component of the document result.
+    When the inputs only flow through element wise operations and scalar builtins, each
+    input is bound to its whole column and the document is evaluated once, so the work of
+    every binding runs through the vector kernels of Value. Otherwise the bindings are
+    evaluated one after the other, still without parsing the document again.
+*/
+struct BatchEvaluator
+{
+    using Columns = std::vector<std::vector<double>>;
+
+    Scope& scope;
+    std::vector<Constant*> inputs;      //Replace the values the inputs were assigned
+    bool vectorized = false;            //The whole batch is evaluated at once
+
+    BatchEvaluator(Scope& scope,const std::vector<std::string>& inputs);
+
+    //columns[i][k] is the value of input i in binding k
+    Columns evaluate(const Columns& columns);
+
+    private:
+
+    std::vector<Expression*> prefix;    //Statements before the result
+    std::vector<Expression*> outputs;   //Result components
+    std::vector<bool> varying;          //Output depends on an input
+
+    Columns evaluate_vectorized(const Columns& columns,size_t n);
+    Columns evaluate_sequential(const Columns& columns,size_t n);
+};
@@ -0,0 +1,228 @@
+#include "express.h"
+#include "expression.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+//Usage: bench [filter]
+//       bench --generate arithmetic|calls|tree|document size
+//Runs every benchmark whose name contains filter and prints one JSON object per line:
+//the benchmark, its size, the iterations timed and the nanoseconds per iteration, the
+//median and the fastest of the samples. --generate prints a synthetic document instead,
+//to be read by expr (for instance with --profile).
+//EXPRESS_BENCH_TIME=<seconds> is the time every benchmark runs for, 0.5 by default.
+//The EXPRESS_* options of the interpreter apply to the documents as usual.
+
+using benchClock = std::chrono::steady_clock;
+
+//Keeps results alive so the work computing them is not optimized away
+static volatile double sink;
+
+static double bench_time()
+{
+    const char* seconds = std::getenv("EXPRESS_BENCH_TIME");
+    double time = seconds ? std::strtod(seconds,nullptr) : 0.5;
+    return time > 0 ? time : 0.5;
+}
+
+//Document of size statements of vector arithmetic, each reading the one before
+static string generate_arithmetic(size_t size)
+{
+    string code = "{\nk = 1;\nv0 = (k, 2, 3, 4, 5, 6, 7, 8);\n";
+    for (size_t i = 1; i <= size; i++)
+    {
+        string previous = "v" + std::to_string(i - 1);
+        code += "v" + std::to_string(i) + " = " + previous + " * " + std::to_string(i % 7 + 1) + " / 8 + " + previous + " - k;\n";
+    }
+    return code + "vsum(v" + std::to_string(size) + ")\n}\n";
+}
+
+//Document summing size calls of a small user function, every argument differs so memoization never hits
+static string generate_calls(size_t size)
+{
+    string code = "{\nk = 1;\nf = (x, y) { x * y + 1 };\ns = 0";
+    for (size_t i = 0; i < size; i++) code += " + f(k, " + std::to_string(i) + ")";
+    return code + ";\ns\n}\n";
+}
+
+//Document whose function t<depth> calls the one below twice, 2^depth calls with distinct arguments
+static string generate_tree(size_t depth)
+{
+    string code = "{\nk = 1;\nt0 = (x) { x * 2 + 1 };\n";
+    for (size_t i = 1; i <= depth; i++)
+    {
+        string callee = "t" + std::to_string(i - 1);
+        code += "t" + std::to_string(i) + " = (x) { " + callee + "(x * 2) + " + callee + "(x * 2 + 1) };\n";
+    }
+    return code + "t" + std::to_string(depth) + "(k)\n}\n";
+}
+
+//Document of size top level statements mixing every construct the printers handle
+static string generate_document(size_t size)
+{
+    string code = "{\nsq = (x) { x * x };\n";
+    for (size_t i = 0; i < size; i++)
+    {
+        string n = std::to_string(i);
+        switch(i % 4)
+        {
+            case 0: code += "a" + n + " = (" + n + ", 2.5, 3) * 2 ^ 3;\n"; break;
+            case 1: code += "a" + n + " = sq(" + n + " + 1) / (4 - 1);\n"; break;
+            case 2: code += "a" + n + " = sin(" + n + ") + sqrt(2) * M_PI;\n"; break;
+            default: code += "a" + n + " = vsum((1, 2, " + n + ")) - a" + std::to_string(i - 1) + "[0];\n"; break;
+        }
+    }
+    return code + "a0\n}\n";
+}
+
+static const std::pair<const char*,string (*)(size_t)> generators[] =
+{
+    {"arithmetic",generate_arithmetic},
+    {"calls",generate_calls},
+    {"tree",generate_tree},
+    {"document",generate_document},
+};
+
+struct Bench
+{
+    string filter;
+    double seconds;
+
+    //Times body, which does one iteration, in samples of as many iterations as fill a fifth of the time
+    void run(const string& name,size_t size,const std::function<void()>& body)
+    {
+        if (name.find(filter) == string::npos) return;
+        static const int samples = 5;
+        body();
+
+        size_t iterations = 1;
+        for (;;)
+        {
+            double elapsed = time(body,iterations);
+            if (elapsed >= seconds / samples / 4 || iterations >= (size_t(1) << 40)) break;
+            iterations *= elapsed > 0 ? std::max(2.0,std::min(100.0,seconds / samples / elapsed)) : 100;
+        }
+
+        std::vector<double> perIteration;
+        for (int i = 0; i < samples; i++) perIteration.push_back(time(body,iterations) * 1e9 / iterations);
+        std::sort(perIteration.begin(),perIteration.end());
+
+        std::printf("{\"benchmark\":\"%s\",\"size\":%zu,\"iterations\":%zu,\"ns_per_iteration\":%.1f,\"ns_min\":%.1f}\n",
+            name.c_str(),size,iterations * samples,perIteration[samples / 2],perIteration[0]);
+        std::fflush(stdout);
+    }
+
+    static double time(const std::function<void()>& body,size_t iterations)
+    {
+        benchClock::time_point start = benchClock::now();
+        for (size_t i = 0; i < iterations; i++) body();
+        return std::chrono::duration<double>(benchClock::now() - start).count();
+    }
+};
+
+static Value ramp(size_t size,double offset)
+{
+    std::vector<double> values(size);
+    for (size_t i = 0; i < size; i++) values[i] = offset + 0.001 * i;
+    return Value(values);
+}
+
+static void bench_values(Bench& bench)
+{
+    for (size_t size : {1,16,1024,65536})
+    {
+        Value a = ramp(size,1), b = ramp(size,2);
+        bench.run("value_add",size,[&] { Value c = a + b; sink = c[0]; });
+        bench.run("value_mul_scalar",size,[&] { Value c = a * Value(1.5); sink = c[0]; });
+        bench.run("value_pow",size,[&] { Value c = a ^ Value(3.0); sink = c[0]; });
+        bench.run("value_div_assign",size,[&] { Value c = a; c /= b; sink = c[0]; });
+        bench.run("value_vsum",size,[&] { sink = vsum(a); });
+        bench.run("value_vprod",size,[&] { sink = vprod(b); });
+    }
+}
+
+//Lookup of a builtin by name from under depth frames that do not have it
+static void bench_resolve(Bench& bench)
+{
+    for (size_t depth : {1,8,64,512})
+    {
+        Scope scope;
+        Layout empty;
+        Frame* previous = scope.current;
+        for (size_t i = 0; i < depth; i++) scope.enter(&empty,scope.current);
+        bench.run("scope_resolve",depth,[&] { sink = scope.resolve("sin") != nullptr; });
+        scope.current = previous;
+    }
+}
+
+//Evaluations of a compiled document after rebinding k, which every statement depends on
+static void bench_program(Bench& bench,const char* name,string (*generate)(size_t),std::initializer_list<size_t> sizes)
+{
+    for (size_t size : sizes)
+    {
+        auto program = ExpressProgram::compile(generate(size));
+        double k = 1;
+        bench.run(name,size,[&]
+        {
+            program->bind("k",k++);
+            sink = program->evaluate()[0];
+        });
+    }
+}
+
+static void bench_parse(Bench& bench)
+{
+    for (size_t size : {100,1000,10000})
+    {
+        string code = generate_document(size);
+        bench.run("parse_document",size,[&]
+        {
+            Scope scope;
+            sink = parse_tree(code,scope) != nullptr;
+        });
+    }
+}
+
+static void bench_latex(Bench& bench)
+{
+    for (size_t size : {10,100,1000})
+    {
+        string code = generate_document(size);
+        string latex;
+        bench.run("latex_document",size,[&]
+        {
+            latex.clear();
+            parse_to_latex(code,latex);
+            sink = latex.size();
+        });
+    }
+}
+
+int main(int argc,char** argv)
+{
+    if (argc > 1 && std::strcmp(argv[1],"--generate") == 0)
+    {
+        if (argc != 4) return 1;
+        for (auto& generator : generators)
+        {
+            if (std::strcmp(argv[2],generator.first) != 0) continue;
+            string code = generator.second(std::strtoul(argv[3],nullptr,10));
+            std::fwrite(code.data(),1,code.size(),stdout);
+            return 0;
+        }
+        std::fprintf(stderr,"Unknown generator %s\n",argv[2]);
+        return 1;
+    }
+
+    Bench bench{argc > 1 ? argv[1] : "",bench_time()};
+    bench_values(bench);
+    bench_resolve(bench);
+    bench_program(bench,"function_calls",generate_calls,{10,100,1000});
+    bench_program(bench,"call_tree",generate_tree,{4,8,12});
+    bench_program(bench,"arithmetic_document",generate_arithmetic,{10,100,1000});
+    bench_parse(bench);
+    bench_latex(bench);
+    return 0;
+}
@@ -0,0 +1,3817 @@
+#include <regex>
+#include <string>
+// A Bison parser, made by GNU Bison 3.8.2.
+
+// Skeleton implementation for Bison LALR(1) parsers in C++
+
+// Copyright (C) 2002-2015, 2018-2021 Free Software Foundation, Inc.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// As a special exception, you may create a larger work that contains
+// part or all of the Bison parser skeleton and distribute that work
+// under terms of your choice, so long as that work isn't itself a
+// parser generator using the skeleton or a modified version thereof
+// as a parser skeleton.  Alternatively, if you modify or redistribute
+// the parser skeleton itself, you may (at your option) remove this
+// special exception, which will cause the skeleton and the resulting
+// Bison output files to be licensed under the GNU General Public
+// License without this special exception.
+
+// This special exception was added by the Free Software Foundation in
+// version 2.2 of Bison.
+
+// DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+// especially those whose name start with YY_ or yy_.  They are
+// private implementation details that can be changed or removed.
+
+
+
+
+
+// "%code requires" blocks.
+#line 10 "/dev/stdin"
+
+#include <string_view>
+#include <value.h>
+#include <expression.h>
+#include <expression_types.h>
+#include <register_types.h>
+#include <express.h>
+struct lexcontext;
+
+#line 53 "build/expr_main.cc.re"
+
+# include <cassert>
+# include <cstdlib> // std::abort
+# include <iostream>
+# include <stdexcept>
+# include <string>
+# include <vector>
+
+#if defined __cplusplus
+# define YY_CPLUSPLUS __cplusplus
+#else
+# define YY_CPLUSPLUS 199711L
+#endif
+
+// Support move semantics when possible.
+#if 201103L <= YY_CPLUSPLUS
+# define YY_MOVE           std::move
+# define YY_MOVE_OR_COPY   move
+# define YY_MOVE_REF(Type) Type&&
+# define YY_RVREF(Type)    Type&&
+# define YY_COPY(Type)     Type
+#else
+# define YY_MOVE
+# define YY_MOVE_OR_COPY   copy
+# define YY_MOVE_REF(Type) Type&
+# define YY_RVREF(Type)    const Type&
+# define YY_COPY(Type)     const Type&
+#endif
+
+// Support noexcept when possible.
+#if 201103L <= YY_CPLUSPLUS
+# define YY_NOEXCEPT noexcept
+# define YY_NOTHROW
+#else
+# define YY_NOEXCEPT
+# define YY_NOTHROW throw ()
+#endif
+
+// Support constexpr when possible.
+#if 201703 <= YY_CPLUSPLUS
+# define YY_CONSTEXPR constexpr
+#else
+# define YY_CONSTEXPR
+#endif
+
+#include <typeinfo>
+#ifndef YY_ASSERT
+# include <cassert>
+# define YY_ASSERT assert
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+
+namespace yy {
+#line 193 "build/expr_main.cc.re"
+
+
+  /// A point in a source file.
+  class position
+  {
+  public:
+    /// Type for file name.
+    typedef const std::string filename_type;
+    /// Type for line and column numbers.
+    typedef int counter_type;
+
+    /// Construct a position.
+    explicit position (filename_type* f = YY_NULLPTR,
+                       counter_type l = 1,
+                       counter_type c = 1)
+      : filename (f)
+      , line (l)
+      , column (c)
+    {}
+
+
+    /// Initialization.
+    void initialize (filename_type* fn = YY_NULLPTR,
+                     counter_type l = 1,
+                     counter_type c = 1)
+    {
+      filename = fn;
+      line = l;
+      column = c;
+    }
+
+    /** \name Line and Column related manipulators
+     ** \{ */
+    /// (line related) Advance to the COUNT next lines.
+    void lines (counter_type count = 1)
+    {
+      if (count)
+        {
+          column = 1;
+          line = add_ (line, count, 1);
+        }
+    }
+
+    /// (column related) Advance to the COUNT next columns.
+    void columns (counter_type count = 1)
+    {
+      column = add_ (column, count, 1);
+    }
+    /** \} */
+
+    /// File name to which this position refers.
+    filename_type* filename;
+    /// Current line number.
+    counter_type line;
+    /// Current column number.
+    counter_type column;
+
+  private:
+    /// Compute max (min, lhs+rhs).
+    static counter_type add_ (counter_type lhs, counter_type rhs, counter_type min)
+    {
+      return lhs + rhs < min ? min : lhs + rhs;
+    }
+  };
+
+  /// Add \a width columns, in place.
+  inline position&
+  operator+= (position& res, position::counter_type width)
+  {
+    res.columns (width);
+    return res;
+  }
+
+  /// Add \a width columns.
+  inline position
+  operator+ (position res, position::counter_type width)
+  {
+    return res += width;
+  }
+
+  /// Subtract \a width columns, in place.
+  inline position&
+  operator-= (position& res, position::counter_type width)
+  {
+    return res += -width;
+  }
+
+  /// Subtract \a width columns.
+  inline position
+  operator- (position res, position::counter_type width)
+  {
+    return res -= width;
+  }
+
+  /** \brief Intercept output stream redirection.
+   ** \param ostr the destination output stream
+   ** \param pos a reference to the position to redirect
+   */
+  template <typename YYChar>
+  std::basic_ostream<YYChar>&
+  operator<< (std::basic_ostream<YYChar>& ostr, const position& pos)
+  {
+    if (pos.filename)
+      ostr << *pos.filename << ':';
+    return ostr << pos.line << '.' << pos.column;
+  }
+
+  /// Two points in a source file.
+  class location
+  {
+  public:
+    /// Type for file name.
+    typedef position::filename_type filename_type;
+    /// Type for line and column numbers.
+    typedef position::counter_type counter_type;
+
+    /// Construct a location from \a b to \a e.
+    location (const position& b, const position& e)
+      : begin (b)
+      , end (e)
+    {}
+
+    /// Construct a 0-width location in \a p.
+    explicit location (const position& p = position ())
+      : begin (p)
+      , end (p)
+    {}
+
+    /// Construct a 0-width location in \a f, \a l, \a c.
+    explicit location (filename_type* f,
+                       counter_type l = 1,
+                       counter_type c = 1)
+      : begin (f, l, c)
+      , end (f, l, c)
+    {}
+
+
+    /// Initialization.
+    void initialize (filename_type* f = YY_NULLPTR,
+                     counter_type l = 1,
+                     counter_type c = 1)
+    {
+      begin.initialize (f, l, c);
+      end = begin;
+    }
+
+    /** \name Line and Column related manipulators
+     ** \{ */
+  public:
+    /// Reset initial location to final location.
+    void step ()
+    {
+      begin = end;
+    }
+
+    /// Extend the current location to the COUNT next columns.
+    void columns (counter_type count = 1)
+    {
+      end += count;
+    }
+
+    /// Extend the current location to the COUNT next lines.
+    void lines (counter_type count = 1)
+    {
+      end.lines (count);
+    }
+    /** \} */
+
+
+  public:
+    /// Beginning of the located region.
+    position begin;
+    /// End of the located region.
+    position end;
+  };
+
+  /// Join two locations, in place.
+  inline location&
+  operator+= (location& res, const location& end)
+  {
+    res.end = end.end;
+    return res;
+  }
+
+  /// Join two locations.
+  inline location
+  operator+ (location res, const location& end)
+  {
+    return res += end;
+  }
+
+  /// Add \a width columns to the end position, in place.
+  inline location&
+  operator+= (location& res, location::counter_type width)
+  {
+    res.columns (width);
+    return res;
+  }
+
+  /// Add \a width columns to the end position.
+  inline location
+  operator+ (location res, location::counter_type width)
+  {
+    return res += width;
+  }
+
+  /// Subtract \a width columns to the end position, in place.
+  inline location&
+  operator-= (location& res, location::counter_type width)
+  {
+    return res += -width;
+  }
+
+  /// Subtract \a width columns to the end position.
+  inline location
+  operator- (location res, location::counter_type width)
+  {
+    return res -= width;
+  }
+
+  /** \brief Intercept output stream redirection.
+   ** \param ostr the destination output stream
+   ** \param loc a reference to the location to redirect
+   **
+   ** Avoid duplicate information.
+   */
+  template <typename YYChar>
+  std::basic_ostream<YYChar>&
+  operator<< (std::basic_ostream<YYChar>& ostr, const location& loc)
+  {
+    location::counter_type end_col
+      = 0 < loc.end.column ? loc.end.column - 1 : 0;
+    ostr << loc.begin;
+    if (loc.end.filename
+        && (!loc.begin.filename
+            || *loc.begin.filename != *loc.end.filename))
+      ostr << '-' << loc.end.filename << ':' << loc.end.line << '.' << end_col;
+    else if (loc.begin.line < loc.end.line)
+      ostr << '-' << loc.end.line << '.' << end_col;
+    else if (loc.begin.column < end_col)
+      ostr << '-' << end_col;
+    return ostr;
+  }
+
+
+  /// A Bison parser.
+  class conj_parser
+  {
+  public:
+#ifdef YYSTYPE
+# ifdef __GNUC__
+#  pragma GCC message "bison: do not #define YYSTYPE in C++, use %define api.value.type"
+# endif
+    typedef YYSTYPE value_type;
+#else
+  /// A buffer to store and retrieve objects.
+  ///
+  /// Sort of a variant, but does not keep track of the nature
+  /// of the stored data, since that knowledge is available
+  /// via the current parser state.
+  class value_type
+  {
+  public:
+    /// Type of *this.
+    typedef value_type self_type;
+
+    /// Empty construction.
+    value_type () YY_NOEXCEPT
+      : yyraw_ ()
+      , yytypeid_ (YY_NULLPTR)
+    {}
+
+    /// Construct and fill.
+    template <typename T>
+    value_type (YY_RVREF (T) t)
+      : yytypeid_ (&typeid (T))
+    {
+      YY_ASSERT (sizeof (T) <= size);
+      new (yyas_<T> ()) T (YY_MOVE (t));
+    }
+
+#if 201103L <= YY_CPLUSPLUS
+    /// Non copyable.
+    value_type (const self_type&) = delete;
+    /// Non copyable.
+    self_type& operator= (const self_type&) = delete;
+#endif
+
+    /// Destruction, allowed only if empty.
+    ~value_type () YY_NOEXCEPT
+    {
+      YY_ASSERT (!yytypeid_);
+    }
+
+# if 201103L <= YY_CPLUSPLUS
+    /// Instantiate a \a T in here from \a t.
+    template <typename T, typename... U>
+    T&
+    emplace (U&&... u)
+    {
+      YY_ASSERT (!yytypeid_);
+      YY_ASSERT (sizeof (T) <= size);
+      yytypeid_ = & typeid (T);
+      return *new (yyas_<T> ()) T (std::forward <U>(u)...);
+    }
+# else
+    /// Instantiate an empty \a T in here.
+    template <typename T>
+    T&
+    emplace ()
+    {
+      YY_ASSERT (!yytypeid_);
+      YY_ASSERT (sizeof (T) <= size);
+      yytypeid_ = & typeid (T);
+      return *new (yyas_<T> ()) T ();
+    }
+
+    /// Instantiate a \a T in here from \a t.
+    template <typename T>
+    T&
+    emplace (const T& t)
+    {
+      YY_ASSERT (!yytypeid_);
+      YY_ASSERT (sizeof (T) <= size);
+      yytypeid_ = & typeid (T);
+      return *new (yyas_<T> ()) T (t);
+    }
+# endif
+
+    /// Instantiate an empty \a T in here.
+    /// Obsolete, use emplace.
+    template <typename T>
+    T&
+    build ()
+    {
+      return emplace<T> ();
+    }
+
+    /// Instantiate a \a T in here from \a t.
+    /// Obsolete, use emplace.
+    template <typename T>
+    T&
+    build (const T& t)
+    {
+      return emplace<T> (t);
+    }
+
+    /// Accessor to a built \a T.
+    template <typename T>
+    T&
+    as () YY_NOEXCEPT
+    {
+      YY_ASSERT (yytypeid_);
+      YY_ASSERT (*yytypeid_ == typeid (T));
+      YY_ASSERT (sizeof (T) <= size);
+      return *yyas_<T> ();
+    }
+
+    /// Const accessor to a built \a T (for %printer).
+    template <typename T>
+    const T&
+    as () const YY_NOEXCEPT
+    {
+      YY_ASSERT (yytypeid_);
+      YY_ASSERT (*yytypeid_ == typeid (T));
+      YY_ASSERT (sizeof (T) <= size);
+      return *yyas_<T> ();
+    }
+
+    /// Swap the content with \a that, of same type.
+    ///
+    /// Both variants must be built beforehand, because swapping the actual
+    /// data requires reading it (with as()), and this is not possible on
+    /// unconstructed variants: it would require some dynamic testing, which
+    /// should not be the variant's responsibility.
+    /// Swapping between built and (possibly) non-built is done with
+    /// self_type::move ().
+    template <typename T>
+    void
+    swap (self_type& that) YY_NOEXCEPT
+    {
+      YY_ASSERT (yytypeid_);
+      YY_ASSERT (*yytypeid_ == *that.yytypeid_);
+      std::swap (as<T> (), that.as<T> ());
+    }
+
+    /// Move the content of \a that to this.
+    ///
+    /// Destroys \a that.
+    template <typename T>
+    void
+    move (self_type& that)
+    {
+# if 201103L <= YY_CPLUSPLUS
+      emplace<T> (std::move (that.as<T> ()));
+# else
+      emplace<T> ();
+      swap<T> (that);
+# endif
+      that.destroy<T> ();
+    }
+
+# if 201103L <= YY_CPLUSPLUS
+    /// Move the content of \a that to this.
+    template <typename T>
+    void
+    move (self_type&& that)
+    {
+      emplace<T> (std::move (that.as<T> ()));
+      that.destroy<T> ();
+    }
+#endif
+
+    /// Copy the content of \a that to this.
+    template <typename T>
+    void
+    copy (const self_type& that)
+    {
+      emplace<T> (that.as<T> ());
+    }
+
+    /// Destroy the stored \a T.
+    template <typename T>
+    void
+    destroy ()
+    {
+      as<T> ().~T ();
+      yytypeid_ = YY_NULLPTR;
+    }
+
+  private:
+#if YY_CPLUSPLUS < 201103L
+    /// Non copyable.
+    value_type (const self_type&);
+    /// Non copyable.
+    self_type& operator= (const self_type&);
+#endif
+
+    /// Accessor to raw memory as \a T.
+    template <typename T>
+    T*
+    yyas_ () YY_NOEXCEPT
+    {
+      void *yyp = yyraw_;
+      return static_cast<T*> (yyp);
+     }
+
+    /// Const accessor to raw memory as \a T.
+    template <typename T>
+    const T*
+    yyas_ () const YY_NOEXCEPT
+    {
+      const void *yyp = yyraw_;
+      return static_cast<const T*> (yyp);
+     }
+
+    /// An auxiliary type to compute the largest semantic type.
+    union union_type
+    {
+      // assignment
+      char dummy1[sizeof (Assignment*)];
+
+      // lvalue
+      char dummy2[sizeof (Constant*)];
+
+      // expression
+      char dummy3[sizeof (Expression*)];
+
+      // expression-item
+      // expression-block
+      char dummy4[sizeof (ExpressionBlock*)];
+
+      // function
+      char dummy5[sizeof (Function*)];
+
+      // function-call
+      char dummy6[sizeof (FunctionCall*)];
+
+      // operation
+      char dummy7[sizeof (Operation*)];
+
+      // return-block
+      char dummy8[sizeof (ReturnExpression*)];
+
+      // svalue
+      char dummy9[sizeof (StringConstant*)];
+
+      // variable
+      char dummy10[sizeof (Variable*)];
+
+      // vector-item
+      // vector
+      char dummy11[sizeof (Vector*)];
+
+      // NUMCONST
+      char dummy12[sizeof (double)];
+
+      // IDENTIFIER
+      // STRINGCONST
+      char dummy13[sizeof (std::string_view)];
+    };
+
+    /// The size of the largest semantic type.
+    enum { size = sizeof (union_type) };
+
+    /// A buffer to store semantic values.
+    union
+    {
+      /// Strongest alignment constraints.
+      long double yyalign_me_;
+      /// A buffer large enough to store any of the semantic values.
+      char yyraw_[size];
+    };
+
+    /// Whether the content is built: if defined, the name of the stored type.
+    const std::type_info *yytypeid_;
+  };
+
+#endif
+    /// Backward compatibility (Bison 3.8).
+    typedef value_type semantic_type;
+
+    /// Symbol locations.
+    typedef location location_type;
+
+    /// Syntax errors thrown from user actions.
+    struct syntax_error : std::runtime_error
+    {
+      syntax_error (const location_type& l, const std::string& m)
+        : std::runtime_error (m)
+        , location (l)
+      {}
+
+      syntax_error (const syntax_error& s)
+        : std::runtime_error (s.what ())
+        , location (s.location)
+      {}
+
+      ~syntax_error () YY_NOEXCEPT YY_NOTHROW;
+
+      location_type location;
+    };
+
+    /// Token kinds.
+    struct token
+    {
+      enum token_kind_type
+      {
+        YYEMPTY = -2,
+    END = 0,                       // END
+    YYerror = 256,                 // error
+    YYUNDEF = 257,                 // "invalid token"
+    IDENTIFIER = 258,              // IDENTIFIER
+    NUMCONST = 259,                // NUMCONST
+    STRINGCONST = 260,             // STRINGCONST
+    RETURN = 261                   // "return"
+      };
+      /// Backward compatibility alias (Bison 3.6).
+      typedef token_kind_type yytokentype;
+    };
+
+    /// Token kind, as returned by yylex.
+    typedef token::token_kind_type token_kind_type;
+
+    /// Backward compatibility alias (Bison 3.6).
+    typedef token_kind_type token_type;
+
+    /// Symbol kinds.
+    struct symbol_kind
+    {
+      enum symbol_kind_type
+      {
+        YYNTOKENS = 21, ///< Number of tokens.
+        S_YYEMPTY = -2,
+        S_YYEOF = 0,                             // END
+        S_YYerror = 1,                           // error
+        S_YYUNDEF = 2,                           // "invalid token"
+        S_IDENTIFIER = 3,                        // IDENTIFIER
+        S_NUMCONST = 4,                          // NUMCONST
+        S_STRINGCONST = 5,                       // STRINGCONST
+        S_RETURN = 6,                            // "return"
+        S_7_ = 7,                                // ';'
+        S_8_ = 8,                                // ','
+        S_9_ = 9,                                // '='
+        S_10_ = 10,                              // '+'
+        S_11_ = 11,                              // '-'
+        S_12_ = 12,                              // '*'
+        S_13_ = 13,                              // '/'
+        S_14_ = 14,                              // '^'
+        S_15_ = 15,                              // '('
+        S_16_ = 16,                              // '['
+        S_17_ = 17,                              // '{'
+        S_18_ = 18,                              // '}'
+        S_19_ = 19,                              // ']'
+        S_20_ = 20,                              // ')'
+        S_YYACCEPT = 21,                         // $accept
+        S_library = 22,                          // library
+        S_23_expression_item = 23,               // expression-item
+        S_24_expression_block = 24,              // expression-block
+        S_25_return_block = 25,                  // return-block
+        S_expression = 26,                       // expression
+        S_lvalue = 27,                           // lvalue
+        S_svalue = 28,                           // svalue
+        S_variable = 29,                         // variable
+        S_assignment = 30,                       // assignment
+        S_function = 31,                         // function
+        S_32_function_call = 32,                 // function-call
+        S_operation = 33,                        // operation
+        S_34_vector_item = 34,                   // vector-item
+        S_vector = 35                            // vector
+      };
+    };
+
+    /// (Internal) symbol kind.
+    typedef symbol_kind::symbol_kind_type symbol_kind_type;
+
+    /// The number of tokens.
+    static const symbol_kind_type YYNTOKENS = symbol_kind::YYNTOKENS;
+
+    /// A complete symbol.
+    ///
+    /// Expects its Base type to provide access to the symbol kind
+    /// via kind ().
+    ///
+    /// Provide access to semantic value and location.
+    template <typename Base>
+    struct basic_symbol : Base
+    {
+      /// Alias to Base.
+      typedef Base super_type;
+
+      /// Default constructor.
+      basic_symbol () YY_NOEXCEPT
+        : value ()
+        , location ()
+      {}
+
+#if 201103L <= YY_CPLUSPLUS
+      /// Move constructor.
+      basic_symbol (basic_symbol&& that)
+        : Base (std::move (that))
+        , value ()
+        , location (std::move (that.location))
+      {
+        switch (this->kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.move< Assignment* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.move< Constant* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.move< Expression* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.move< ExpressionBlock* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_function: // function
+        value.move< Function* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.move< FunctionCall* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.move< Operation* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.move< ReturnExpression* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.move< StringConstant* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.move< Variable* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.move< Vector* > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.move< double > (std::move (that.value));
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.move< std::string_view > (std::move (that.value));
+        break;
+
+      default:
+        break;
+    }
+
+      }
+#endif
+
+      /// Copy constructor.
+      basic_symbol (const basic_symbol& that);
+
+      /// Constructors for typed symbols.
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, location_type&& l)
+        : Base (t)
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const location_type& l)
+        : Base (t)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Assignment*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Assignment*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Constant*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Constant*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Expression*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Expression*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, ExpressionBlock*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const ExpressionBlock*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Function*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Function*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, FunctionCall*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const FunctionCall*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Operation*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Operation*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, ReturnExpression*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const ReturnExpression*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, StringConstant*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const StringConstant*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Variable*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Variable*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, Vector*&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const Vector*& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, double&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const double& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+#if 201103L <= YY_CPLUSPLUS
+      basic_symbol (typename Base::kind_type t, std::string_view&& v, location_type&& l)
+        : Base (t)
+        , value (std::move (v))
+        , location (std::move (l))
+      {}
+#else
+      basic_symbol (typename Base::kind_type t, const std::string_view& v, const location_type& l)
+        : Base (t)
+        , value (v)
+        , location (l)
+      {}
+#endif
+
+      /// Destroy the symbol.
+      ~basic_symbol ()
+      {
+        clear ();
+      }
+
+
+
+      /// Destroy contents, and record that is empty.
+      void clear () YY_NOEXCEPT
+      {
+        // User destructor.
+        symbol_kind_type yykind = this->kind ();
+        basic_symbol<Base>& yysym = *this;
+        (void) yysym;
+        switch (yykind)
+        {
+       default:
+          break;
+        }
+
+        // Value type destructor.
+switch (yykind)
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.template destroy< Assignment* > ();
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.template destroy< Constant* > ();
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.template destroy< Expression* > ();
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.template destroy< ExpressionBlock* > ();
+        break;
+
+      case symbol_kind::S_function: // function
+        value.template destroy< Function* > ();
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.template destroy< FunctionCall* > ();
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.template destroy< Operation* > ();
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.template destroy< ReturnExpression* > ();
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.template destroy< StringConstant* > ();
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.template destroy< Variable* > ();
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.template destroy< Vector* > ();
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.template destroy< double > ();
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.template destroy< std::string_view > ();
+        break;
+
+      default:
+        break;
+    }
+
+        Base::clear ();
+      }
+
+      /// The user-facing name of this symbol.
+      std::string name () const YY_NOEXCEPT
+      {
+        return conj_parser::symbol_name (this->kind ());
+      }
+
+      /// Backward compatibility (Bison 3.6).
+      symbol_kind_type type_get () const YY_NOEXCEPT;
+
+      /// Whether empty.
+      bool empty () const YY_NOEXCEPT;
+
+      /// Destructive move, \a s is emptied into this.
+      void move (basic_symbol& s);
+
+      /// The semantic value.
+      value_type value;
+
+      /// The location.
+      location_type location;
+
+    private:
+#if YY_CPLUSPLUS < 201103L
+      /// Assignment operator.
+      basic_symbol& operator= (const basic_symbol& that);
+#endif
+    };
+
+    /// Type access provider for token (enum) based symbols.
+    struct by_kind
+    {
+      /// The symbol kind as needed by the constructor.
+      typedef token_kind_type kind_type;
+
+      /// Default constructor.
+      by_kind () YY_NOEXCEPT;
+
+#if 201103L <= YY_CPLUSPLUS
+      /// Move constructor.
+      by_kind (by_kind&& that) YY_NOEXCEPT;
+#endif
+
+      /// Copy constructor.
+      by_kind (const by_kind& that) YY_NOEXCEPT;
+
+      /// Constructor from (external) token numbers.
+      by_kind (kind_type t) YY_NOEXCEPT;
+
+
+
+      /// Record that this symbol is empty.
+      void clear () YY_NOEXCEPT;
+
+      /// Steal the symbol kind from \a that.
+      void move (by_kind& that);
+
+      /// The (internal) type number (corresponding to \a type).
+      /// \a empty when empty.
+      symbol_kind_type kind () const YY_NOEXCEPT;
+
+      /// Backward compatibility (Bison 3.6).
+      symbol_kind_type type_get () const YY_NOEXCEPT;
+
+      /// The symbol kind.
+      /// \a S_YYEMPTY when empty.
+      symbol_kind_type kind_;
+    };
+
+    /// Backward compatibility for a private implementation detail (Bison 3.6).
+    typedef by_kind by_type;
+
+    /// "External" symbols: returned by the scanner.
+    struct symbol_type : basic_symbol<by_kind>
+    {
+      /// Superclass.
+      typedef basic_symbol<by_kind> super_type;
+
+      /// Empty symbol.
+      symbol_type () YY_NOEXCEPT {}
+
+      /// Constructor for valueless symbols, and symbols from each type.
+#if 201103L <= YY_CPLUSPLUS
+      symbol_type (int tok, location_type l)
+        : super_type (token_kind_type (tok), std::move (l))
+#else
+      symbol_type (int tok, const location_type& l)
+        : super_type (token_kind_type (tok), l)
+#endif
+      {
+#if !defined _MSC_VER || defined __clang__
+        YY_ASSERT (tok == token::END
+                   || (token::YYerror <= tok && tok <= token::YYUNDEF)
+                   || tok == token::RETURN
+                   || tok == 59
+                   || tok == 44
+                   || tok == 61
+                   || tok == 43
+                   || tok == 45
+                   || tok == 42
+                   || tok == 47
+                   || tok == 94
+                   || tok == 40
+                   || tok == 91
+                   || tok == 123
+                   || tok == 125
+                   || tok == 93
+                   || tok == 41);
+#endif
+      }
+#if 201103L <= YY_CPLUSPLUS
+      symbol_type (int tok, double v, location_type l)
+        : super_type (token_kind_type (tok), std::move (v), std::move (l))
+#else
+      symbol_type (int tok, const double& v, const location_type& l)
+        : super_type (token_kind_type (tok), v, l)
+#endif
+      {
+#if !defined _MSC_VER || defined __clang__
+        YY_ASSERT (tok == token::NUMCONST);
+#endif
+      }
+#if 201103L <= YY_CPLUSPLUS
+      symbol_type (int tok, std::string_view v, location_type l)
+        : super_type (token_kind_type (tok), std::move (v), std::move (l))
+#else
+      symbol_type (int tok, const std::string_view& v, const location_type& l)
+        : super_type (token_kind_type (tok), v, l)
+#endif
+      {
+#if !defined _MSC_VER || defined __clang__
+        YY_ASSERT (tok == token::IDENTIFIER
+                   || tok == token::STRINGCONST);
+#endif
+      }
+    };
+
+    /// Build a parser object.
+    conj_parser (lexcontext& lex_yyarg);
+    virtual ~conj_parser ();
+
+#if 201103L <= YY_CPLUSPLUS
+    /// Non copyable.
+    conj_parser (const conj_parser&) = delete;
+    /// Non copyable.
+    conj_parser& operator= (const conj_parser&) = delete;
+#endif
+
+    /// Parse.  An alias for parse ().
+    /// \returns  0 iff parsing succeeded.
+    int operator() ();
+
+    /// Parse.
+    /// \returns  0 iff parsing succeeded.
+    virtual int parse ();
+
+#if YYDEBUG
+    /// The current debugging stream.
+    std::ostream& debug_stream () const YY_ATTRIBUTE_PURE;
+    /// Set the current debugging stream.
+    void set_debug_stream (std::ostream &);
+
+    /// Type for debugging levels.
+    typedef int debug_level_type;
+    /// The current debugging level.
+    debug_level_type debug_level () const YY_ATTRIBUTE_PURE;
+    /// Set the current debugging level.
+    void set_debug_level (debug_level_type l);
+#endif
+
+    /// Report a syntax error.
+    /// \param loc    where the syntax error is found.
+    /// \param msg    a description of the syntax error.
+    virtual void error (const location_type& loc, const std::string& msg);
+
+    /// Report a syntax error.
+    void error (const syntax_error& err);
+
+    /// The user-facing name of the symbol whose (internal) number is
+    /// YYSYMBOL.  No bounds checking.
+    static std::string symbol_name (symbol_kind_type yysymbol);
+
+    // Implementation of make_symbol for each token kind.
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_END (location_type l)
+      {
+        return symbol_type (token::END, std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_END (const location_type& l)
+      {
+        return symbol_type (token::END, l);
+      }
+#endif
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_YYerror (location_type l)
+      {
+        return symbol_type (token::YYerror, std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_YYerror (const location_type& l)
+      {
+        return symbol_type (token::YYerror, l);
+      }
+#endif
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_YYUNDEF (location_type l)
+      {
+        return symbol_type (token::YYUNDEF, std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_YYUNDEF (const location_type& l)
+      {
+        return symbol_type (token::YYUNDEF, l);
+      }
+#endif
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_IDENTIFIER (std::string_view v, location_type l)
+      {
+        return symbol_type (token::IDENTIFIER, std::move (v), std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_IDENTIFIER (const std::string_view& v, const location_type& l)
+      {
+        return symbol_type (token::IDENTIFIER, v, l);
+      }
+#endif
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_NUMCONST (double v, location_type l)
+      {
+        return symbol_type (token::NUMCONST, std::move (v), std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_NUMCONST (const double& v, const location_type& l)
+      {
+        return symbol_type (token::NUMCONST, v, l);
+      }
+#endif
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_STRINGCONST (std::string_view v, location_type l)
+      {
+        return symbol_type (token::STRINGCONST, std::move (v), std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_STRINGCONST (const std::string_view& v, const location_type& l)
+      {
+        return symbol_type (token::STRINGCONST, v, l);
+      }
+#endif
+#if 201103L <= YY_CPLUSPLUS
+      static
+      symbol_type
+      make_RETURN (location_type l)
+      {
+        return symbol_type (token::RETURN, std::move (l));
+      }
+#else
+      static
+      symbol_type
+      make_RETURN (const location_type& l)
+      {
+        return symbol_type (token::RETURN, l);
+      }
+#endif
+
+
+    class context
+    {
+    public:
+      context (const conj_parser& yyparser, const symbol_type& yyla);
+      const symbol_type& lookahead () const YY_NOEXCEPT { return yyla_; }
+      symbol_kind_type token () const YY_NOEXCEPT { return yyla_.kind (); }
+      const location_type& location () const YY_NOEXCEPT { return yyla_.location; }
+
+      /// Put in YYARG at most YYARGN of the expected tokens, and return the
+      /// number of tokens stored in YYARG.  If YYARG is null, return the
+      /// number of expected tokens (guaranteed to be less than YYNTOKENS).
+      int expected_tokens (symbol_kind_type yyarg[], int yyargn) const;
+
+    private:
+      const conj_parser& yyparser_;
+      const symbol_type& yyla_;
+    };
+
+  private:
+#if YY_CPLUSPLUS < 201103L
+    /// Non copyable.
+    conj_parser (const conj_parser&);
+    /// Non copyable.
+    conj_parser& operator= (const conj_parser&);
+#endif
+
+
+    /// Stored state numbers (used for stacks).
+    typedef signed char state_type;
+
+    /// The arguments of the error message.
+    int yy_syntax_error_arguments_ (const context& yyctx,
+                                    symbol_kind_type yyarg[], int yyargn) const;
+
+    /// Generate an error message.
+    /// \param yyctx     the context in which the error occurred.
+    virtual std::string yysyntax_error_ (const context& yyctx) const;
+    /// Compute post-reduction state.
+    /// \param yystate   the current state
+    /// \param yysym     the nonterminal to push on the stack
+    static state_type yy_lr_goto_state_ (state_type yystate, int yysym);
+
+    /// Whether the given \c yypact_ value indicates a defaulted state.
+    /// \param yyvalue   the value to check
+    static bool yy_pact_value_is_default_ (int yyvalue) YY_NOEXCEPT;
+
+    /// Whether the given \c yytable_ value indicates a syntax error.
+    /// \param yyvalue   the value to check
+    static bool yy_table_value_is_error_ (int yyvalue) YY_NOEXCEPT;
+
+    static const signed char yypact_ninf_;
+    static const signed char yytable_ninf_;
+
+    /// Convert a scanner token kind \a t to a symbol kind.
+    /// In theory \a t should be a token_kind_type, but character literals
+    /// are valid, yet not members of the token_kind_type enum.
+    static symbol_kind_type yytranslate_ (int t) YY_NOEXCEPT;
+
+    /// Convert the symbol name \a n to a form suitable for a diagnostic.
+    static std::string yytnamerr_ (const char *yystr);
+
+    /// For a symbol, its name in clear.
+    static const char* const yytname_[];
+
+
+    // Tables.
+    // YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+    // STATE-NUM.
+    static const signed char yypact_[];
+
+    // YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+    // Performed when YYTABLE does not specify something else to do.  Zero
+    // means the default is an error.
+    static const signed char yydefact_[];
+
+    // YYPGOTO[NTERM-NUM].
+    static const signed char yypgoto_[];
+
+    // YYDEFGOTO[NTERM-NUM].
+    static const signed char yydefgoto_[];
+
+    // YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+    // positive, shift that token.  If negative, reduce the rule whose
+    // number is the opposite.  If YYTABLE_NINF, syntax error.
+    static const signed char yytable_[];
+
+    static const signed char yycheck_[];
+
+    // YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+    // state STATE-NUM.
+    static const signed char yystos_[];
+
+    // YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.
+    static const signed char yyr1_[];
+
+    // YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.
+    static const signed char yyr2_[];
+
+
+#if YYDEBUG
+    // YYRLINE[YYN] -- Source line where rule number YYN was defined.
+    static const unsigned char yyrline_[];
+    /// Report on the debug stream that the rule \a r is going to be reduced.
+    virtual void yy_reduce_print_ (int r) const;
+    /// Print the state stack on the debug stream.
+    virtual void yy_stack_print_ () const;
+
+    /// Debugging level.
+    int yydebug_;
+    /// Debug stream.
+    std::ostream* yycdebug_;
+
+    /// \brief Display a symbol kind, value and location.
+    /// \param yyo    The output stream.
+    /// \param yysym  The symbol.
+    template <typename Base>
+    void yy_print_ (std::ostream& yyo, const basic_symbol<Base>& yysym) const;
+#endif
+
+    /// \brief Reclaim the memory associated to a symbol.
+    /// \param yymsg     Why this token is reclaimed.
+    ///                  If null, print nothing.
+    /// \param yysym     The symbol.
+    template <typename Base>
+    void yy_destroy_ (const char* yymsg, basic_symbol<Base>& yysym) const;
+
+  private:
+    /// Type access provider for state based symbols.
+    struct by_state
+    {
+      /// Default constructor.
+      by_state () YY_NOEXCEPT;
+
+      /// The symbol kind as needed by the constructor.
+      typedef state_type kind_type;
+
+      /// Constructor.
+      by_state (kind_type s) YY_NOEXCEPT;
+
+      /// Copy constructor.
+      by_state (const by_state& that) YY_NOEXCEPT;
+
+      /// Record that this symbol is empty.
+      void clear () YY_NOEXCEPT;
+
+      /// Steal the symbol kind from \a that.
+      void move (by_state& that);
+
+      /// The symbol kind (corresponding to \a state).
+      /// \a symbol_kind::S_YYEMPTY when empty.
+      symbol_kind_type kind () const YY_NOEXCEPT;
+
+      /// The state number used to denote an empty symbol.
+      /// We use the initial state, as it does not have a value.
+      enum { empty_state = 0 };
+
+      /// The state.
+      /// \a empty when empty.
+      state_type state;
+    };
+
+    /// "Internal" symbol: element of the stack.
+    struct stack_symbol_type : basic_symbol<by_state>
+    {
+      /// Superclass.
+      typedef basic_symbol<by_state> super_type;
+      /// Construct an empty symbol.
+      stack_symbol_type ();
+      /// Move or copy construction.
+      stack_symbol_type (YY_RVREF (stack_symbol_type) that);
+      /// Steal the contents from \a sym to build this.
+      stack_symbol_type (state_type s, YY_MOVE_REF (symbol_type) sym);
+#if YY_CPLUSPLUS < 201103L
+      /// Assignment, needed by push_back by some old implementations.
+      /// Moves the contents of that.
+      stack_symbol_type& operator= (stack_symbol_type& that);
+
+      /// Assignment, needed by push_back by other implementations.
+      /// Needed by some other old implementations.
+      stack_symbol_type& operator= (const stack_symbol_type& that);
+#endif
+    };
+
+    /// A stack with random access from its top.
+    template <typename T, typename S = std::vector<T> >
+    class stack
+    {
+    public:
+      // Hide our reversed order.
+      typedef typename S::iterator iterator;
+      typedef typename S::const_iterator const_iterator;
+      typedef typename S::size_type size_type;
+      typedef typename std::ptrdiff_t index_type;
+
+      stack (size_type n = 200) YY_NOEXCEPT
+        : seq_ (n)
+      {}
+
+#if 201103L <= YY_CPLUSPLUS
+      /// Non copyable.
+      stack (const stack&) = delete;
+      /// Non copyable.
+      stack& operator= (const stack&) = delete;
+#endif
+
+      /// Random access.
+      ///
+      /// Index 0 returns the topmost element.
+      const T&
+      operator[] (index_type i) const
+      {
+        return seq_[size_type (size () - 1 - i)];
+      }
+
+      /// Random access.
+      ///
+      /// Index 0 returns the topmost element.
+      T&
+      operator[] (index_type i)
+      {
+        return seq_[size_type (size () - 1 - i)];
+      }
+
+      /// Steal the contents of \a t.
+      ///
+      /// Close to move-semantics.
+      void
+      push (YY_MOVE_REF (T) t)
+      {
+        seq_.push_back (T ());
+        operator[] (0).move (t);
+      }
+
+      /// Pop elements from the stack.
+      void
+      pop (std::ptrdiff_t n = 1) YY_NOEXCEPT
+      {
+        for (; 0 < n; --n)
+          seq_.pop_back ();
+      }
+
+      /// Pop all elements from the stack.
+      void
+      clear () YY_NOEXCEPT
+      {
+        seq_.clear ();
+      }
+
+      /// Number of elements on the stack.
+      index_type
+      size () const YY_NOEXCEPT
+      {
+        return index_type (seq_.size ());
+      }
+
+      /// Iterator on top of the stack (going downwards).
+      const_iterator
+      begin () const YY_NOEXCEPT
+      {
+        return seq_.begin ();
+      }
+
+      /// Bottom of the stack.
+      const_iterator
+      end () const YY_NOEXCEPT
+      {
+        return seq_.end ();
+      }
+
+      /// Present a slice of the top of a stack.
+      class slice
+      {
+      public:
+        slice (const stack& stack, index_type range) YY_NOEXCEPT
+          : stack_ (stack)
+          , range_ (range)
+        {}
+
+        const T&
+        operator[] (index_type i) const
+        {
+          return stack_[range_ - i];
+        }
+
+      private:
+        const stack& stack_;
+        index_type range_;
+      };
+
+    private:
+#if YY_CPLUSPLUS < 201103L
+      /// Non copyable.
+      stack (const stack&);
+      /// Non copyable.
+      stack& operator= (const stack&);
+#endif
+      /// The wrapped container.
+      S seq_;
+    };
+
+
+    /// Stack type.
+    typedef stack<stack_symbol_type> stack_type;
+
+    /// The stack.
+    stack_type yystack_;
+
+    /// Push a new state on the stack.
+    /// \param m    a debug message to display
+    ///             if null, no trace is output.
+    /// \param sym  the symbol
+    /// \warning the contents of \a s.value is stolen.
+    void yypush_ (const char* m, YY_MOVE_REF (stack_symbol_type) sym);
+
+    /// Push a new look ahead token on the state on the stack.
+    /// \param m    a debug message to display
+    ///             if null, no trace is output.
+    /// \param s    the state
+    /// \param sym  the symbol (for its value and location).
+    /// \warning the contents of \a sym.value is stolen.
+    void yypush_ (const char* m, state_type s, YY_MOVE_REF (symbol_type) sym);
+
+    /// Pop \a n symbols from the stack.
+    void yypop_ (int n = 1) YY_NOEXCEPT;
+
+    /// Constants.
+    enum
+    {
+      yylast_ = 75,     ///< Last index in yytable_.
+      yynnts_ = 15,  ///< Number of nonterminal symbols.
+      yyfinal_ = 26 ///< Termination state number.
+    };
+
+
+    // User arguments.
+    lexcontext& lex;
+
+  };
+
+  conj_parser::symbol_kind_type
+  conj_parser::yytranslate_ (int t) YY_NOEXCEPT
+  {
+    // YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to
+    // TOKEN-NUM as returned by yylex.
+    static
+    const signed char
+    translate_table[] =
+    {
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      15,    20,    12,    10,     8,    11,     2,    13,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     7,
+       2,     9,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,    16,     2,    19,    14,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    17,     2,    18,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6
+    };
+    // Last valid token kind.
+    const int code_max = 261;
+
+    if (t <= 0)
+      return symbol_kind::S_YYEOF;
+    else if (t <= code_max)
+      return static_cast <symbol_kind_type> (translate_table[t]);
+    else
+      return symbol_kind::S_YYUNDEF;
+  }
+
+  // basic_symbol.
+  template <typename Base>
+  conj_parser::basic_symbol<Base>::basic_symbol (const basic_symbol& that)
+    : Base (that)
+    , value ()
+    , location (that.location)
+  {
+    switch (this->kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.copy< Assignment* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.copy< Constant* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.copy< Expression* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.copy< ExpressionBlock* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_function: // function
+        value.copy< Function* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.copy< FunctionCall* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.copy< Operation* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.copy< ReturnExpression* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.copy< StringConstant* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.copy< Variable* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.copy< Vector* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.copy< double > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.copy< std::string_view > (YY_MOVE (that.value));
+        break;
+
+      default:
+        break;
+    }
+
+  }
+
+
+
+
+  template <typename Base>
+  conj_parser::symbol_kind_type
+  conj_parser::basic_symbol<Base>::type_get () const YY_NOEXCEPT
+  {
+    return this->kind ();
+  }
+
+
+  template <typename Base>
+  bool
+  conj_parser::basic_symbol<Base>::empty () const YY_NOEXCEPT
+  {
+    return this->kind () == symbol_kind::S_YYEMPTY;
+  }
+
+  template <typename Base>
+  void
+  conj_parser::basic_symbol<Base>::move (basic_symbol& s)
+  {
+    super_type::move (s);
+    switch (this->kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.move< Assignment* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.move< Constant* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.move< Expression* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.move< ExpressionBlock* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_function: // function
+        value.move< Function* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.move< FunctionCall* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.move< Operation* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.move< ReturnExpression* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.move< StringConstant* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.move< Variable* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.move< Vector* > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.move< double > (YY_MOVE (s.value));
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.move< std::string_view > (YY_MOVE (s.value));
+        break;
+
+      default:
+        break;
+    }
+
+    location = YY_MOVE (s.location);
+  }
+
+  // by_kind.
+  conj_parser::by_kind::by_kind () YY_NOEXCEPT
+    : kind_ (symbol_kind::S_YYEMPTY)
+  {}
+
+#if 201103L <= YY_CPLUSPLUS
+  conj_parser::by_kind::by_kind (by_kind&& that) YY_NOEXCEPT
+    : kind_ (that.kind_)
+  {
+    that.clear ();
+  }
+#endif
+
+  conj_parser::by_kind::by_kind (const by_kind& that) YY_NOEXCEPT
+    : kind_ (that.kind_)
+  {}
+
+  conj_parser::by_kind::by_kind (token_kind_type t) YY_NOEXCEPT
+    : kind_ (yytranslate_ (t))
+  {}
+
+
+
+  void
+  conj_parser::by_kind::clear () YY_NOEXCEPT
+  {
+    kind_ = symbol_kind::S_YYEMPTY;
+  }
+
+  void
+  conj_parser::by_kind::move (by_kind& that)
+  {
+    kind_ = that.kind_;
+    that.clear ();
+  }
+
+  conj_parser::symbol_kind_type
+  conj_parser::by_kind::kind () const YY_NOEXCEPT
+  {
+    return kind_;
+  }
+
+
+  conj_parser::symbol_kind_type
+  conj_parser::by_kind::type_get () const YY_NOEXCEPT
+  {
+    return this->kind ();
+  }
+
+
+} // yy
+#line 2070 "build/expr_main.cc.re"
+
+
+
+
+
+
+// Unqualified %code blocks.
+#line 22 "/dev/stdin"
+
+#include <charconv>
+#include "ast_cache.h"
+#include "mapped_file.h"
+struct lexcontext
+{
+    const char* cursor;
+    const char* marker;
+    yy::location loc;
+    Scope* scope;                       //Document being parsed
+    Expression* root = nullptr;         //Set once the whole document is parsed
+
+    //Nodes live in the arena of the document and are released with its Scope
+    template <typename T,typename ... Args>
+    T* make(const yy::location& loc,Args&& ... args) { return locate(scope->arena.make<T>(std::forward<Args>(args)...),loc); }
+
+    //Node spans the text of loc, for error messages and profiles
+    template <typename T>
+    T* locate(T* node,const yy::location& loc)
+    {
+        node->span.line = loc.begin.line;
+        node->span.column = loc.begin.column;
+        node->span.endLine = loc.end.line;
+        node->span.endColumn = loc.end.column;
+        return node;
+    }
+};
+namespace yy { conj_parser::symbol_type yylex(lexcontext& ctx); }
+
+#line 2108 "build/expr_main.cc.re"
+
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> // FIXME: INFRINGES ON USER NAME SPACE.
+#   define YY_(msgid) dgettext ("bison-runtime", msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(msgid) msgid
+# endif
+#endif
+
+
+// Whether we are compiled with exception support.
+#ifndef YY_EXCEPTIONS
+# if defined __GNUC__ && !defined __EXCEPTIONS
+#  define YY_EXCEPTIONS 0
+# else
+#  define YY_EXCEPTIONS 1
+# endif
+#endif
+
+#define YYRHSLOC(Rhs, K) ((Rhs)[K].location)
+/* YYLLOC_DEFAULT -- Set CURRENT to span from RHS[1] to RHS[N].
+   If N is 0, then set CURRENT to the empty location which ends
+   the previous symbol: RHS[0] (always defined).  */
+
+# ifndef YYLLOC_DEFAULT
+#  define YYLLOC_DEFAULT(Current, Rhs, N)                               \
+    do                                                                  \
+      if (N)                                                            \
+        {                                                               \
+          (Current).begin  = YYRHSLOC (Rhs, 1).begin;                   \
+          (Current).end    = YYRHSLOC (Rhs, N).end;                     \
+        }                                                               \
+      else                                                              \
+        {                                                               \
+          (Current).begin = (Current).end = YYRHSLOC (Rhs, 0).end;      \
+        }                                                               \
+    while (false)
+# endif
+
+
+// Enable debugging if requested.
+#if YYDEBUG
+
+// A pseudo ostream that takes yydebug_ into account.
+# define YYCDEBUG if (yydebug_) (*yycdebug_)
+
+# define YY_SYMBOL_PRINT(Title, Symbol)         \
+  do {                                          \
+    if (yydebug_)                               \
+    {                                           \
+      *yycdebug_ << Title << ' ';               \
+      yy_print_ (*yycdebug_, Symbol);           \
+      *yycdebug_ << '\n';                       \
+    }                                           \
+  } while (false)
+
+# define YY_REDUCE_PRINT(Rule)          \
+  do {                                  \
+    if (yydebug_)                       \
+      yy_reduce_print_ (Rule);          \
+  } while (false)
+
+# define YY_STACK_PRINT()               \
+  do {                                  \
+    if (yydebug_)                       \
+      yy_stack_print_ ();                \
+  } while (false)
+
+#else // !YYDEBUG
+
+# define YYCDEBUG if (false) std::cerr
+# define YY_SYMBOL_PRINT(Title, Symbol)  YY_USE (Symbol)
+# define YY_REDUCE_PRINT(Rule)           static_cast<void> (0)
+# define YY_STACK_PRINT()                static_cast<void> (0)
+
+#endif // !YYDEBUG
+
+#define yyerrok         (yyerrstatus_ = 0)
+#define yyclearin       (yyla.clear ())
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYRECOVERING()  (!!yyerrstatus_)
+
+namespace yy {
+#line 2200 "build/expr_main.cc.re"
+
+  /// Build a parser object.
+  conj_parser::conj_parser (lexcontext& lex_yyarg)
+#if YYDEBUG
+    : yydebug_ (false),
+      yycdebug_ (&std::cerr),
+#else
+    :
+#endif
+      lex (lex_yyarg)
+  {}
+
+  conj_parser::~conj_parser ()
+  {}
+
+  conj_parser::syntax_error::~syntax_error () YY_NOEXCEPT YY_NOTHROW
+  {}
+
+  /*---------.
+  | symbol.  |
+  `---------*/
+
+
+
+  // by_state.
+  conj_parser::by_state::by_state () YY_NOEXCEPT
+    : state (empty_state)
+  {}
+
+  conj_parser::by_state::by_state (const by_state& that) YY_NOEXCEPT
+    : state (that.state)
+  {}
+
+  void
+  conj_parser::by_state::clear () YY_NOEXCEPT
+  {
+    state = empty_state;
+  }
+
+  void
+  conj_parser::by_state::move (by_state& that)
+  {
+    state = that.state;
+    that.clear ();
+  }
+
+  conj_parser::by_state::by_state (state_type s) YY_NOEXCEPT
+    : state (s)
+  {}
+
+  conj_parser::symbol_kind_type
+  conj_parser::by_state::kind () const YY_NOEXCEPT
+  {
+    if (state == empty_state)
+      return symbol_kind::S_YYEMPTY;
+    else
+      return YY_CAST (symbol_kind_type, yystos_[+state]);
+  }
+
+  conj_parser::stack_symbol_type::stack_symbol_type ()
+  {}
+
+  conj_parser::stack_symbol_type::stack_symbol_type (YY_RVREF (stack_symbol_type) that)
+    : super_type (YY_MOVE (that.state), YY_MOVE (that.location))
+  {
+    switch (that.kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.YY_MOVE_OR_COPY< Assignment* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.YY_MOVE_OR_COPY< Constant* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.YY_MOVE_OR_COPY< Expression* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.YY_MOVE_OR_COPY< ExpressionBlock* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_function: // function
+        value.YY_MOVE_OR_COPY< Function* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.YY_MOVE_OR_COPY< FunctionCall* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.YY_MOVE_OR_COPY< Operation* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.YY_MOVE_OR_COPY< ReturnExpression* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.YY_MOVE_OR_COPY< StringConstant* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.YY_MOVE_OR_COPY< Variable* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.YY_MOVE_OR_COPY< Vector* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.YY_MOVE_OR_COPY< double > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.YY_MOVE_OR_COPY< std::string_view > (YY_MOVE (that.value));
+        break;
+
+      default:
+        break;
+    }
+
+#if 201103L <= YY_CPLUSPLUS
+    // that is emptied.
+    that.state = empty_state;
+#endif
+  }
+
+  conj_parser::stack_symbol_type::stack_symbol_type (state_type s, YY_MOVE_REF (symbol_type) that)
+    : super_type (s, YY_MOVE (that.location))
+  {
+    switch (that.kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.move< Assignment* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.move< Constant* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.move< Expression* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.move< ExpressionBlock* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_function: // function
+        value.move< Function* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.move< FunctionCall* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.move< Operation* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.move< ReturnExpression* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.move< StringConstant* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.move< Variable* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.move< Vector* > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.move< double > (YY_MOVE (that.value));
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.move< std::string_view > (YY_MOVE (that.value));
+        break;
+
+      default:
+        break;
+    }
+
+    // that is emptied.
+    that.kind_ = symbol_kind::S_YYEMPTY;
+  }
+
+#if YY_CPLUSPLUS < 201103L
+  conj_parser::stack_symbol_type&
+  conj_parser::stack_symbol_type::operator= (const stack_symbol_type& that)
+  {
+    state = that.state;
+    switch (that.kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.copy< Assignment* > (that.value);
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.copy< Constant* > (that.value);
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.copy< Expression* > (that.value);
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.copy< ExpressionBlock* > (that.value);
+        break;
+
+      case symbol_kind::S_function: // function
+        value.copy< Function* > (that.value);
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.copy< FunctionCall* > (that.value);
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.copy< Operation* > (that.value);
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.copy< ReturnExpression* > (that.value);
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.copy< StringConstant* > (that.value);
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.copy< Variable* > (that.value);
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.copy< Vector* > (that.value);
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.copy< double > (that.value);
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.copy< std::string_view > (that.value);
+        break;
+
+      default:
+        break;
+    }
+
+    location = that.location;
+    return *this;
+  }
+
+  conj_parser::stack_symbol_type&
+  conj_parser::stack_symbol_type::operator= (stack_symbol_type& that)
+  {
+    state = that.state;
+    switch (that.kind ())
+    {
+      case symbol_kind::S_assignment: // assignment
+        value.move< Assignment* > (that.value);
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        value.move< Constant* > (that.value);
+        break;
+
+      case symbol_kind::S_expression: // expression
+        value.move< Expression* > (that.value);
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        value.move< ExpressionBlock* > (that.value);
+        break;
+
+      case symbol_kind::S_function: // function
+        value.move< Function* > (that.value);
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        value.move< FunctionCall* > (that.value);
+        break;
+
+      case symbol_kind::S_operation: // operation
+        value.move< Operation* > (that.value);
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        value.move< ReturnExpression* > (that.value);
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        value.move< StringConstant* > (that.value);
+        break;
+
+      case symbol_kind::S_variable: // variable
+        value.move< Variable* > (that.value);
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        value.move< Vector* > (that.value);
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        value.move< double > (that.value);
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        value.move< std::string_view > (that.value);
+        break;
+
+      default:
+        break;
+    }
+
+    location = that.location;
+    // that is emptied.
+    that.state = empty_state;
+    return *this;
+  }
+#endif
+
+  template <typename Base>
+  void
+  conj_parser::yy_destroy_ (const char* yymsg, basic_symbol<Base>& yysym) const
+  {
+    if (yymsg)
+      YY_SYMBOL_PRINT (yymsg, yysym);
+  }
+
+#if YYDEBUG
+  template <typename Base>
+  void
+  conj_parser::yy_print_ (std::ostream& yyo, const basic_symbol<Base>& yysym) const
+  {
+    std::ostream& yyoutput = yyo;
+    YY_USE (yyoutput);
+    if (yysym.empty ())
+      yyo << "empty symbol";
+    else
+      {
+        symbol_kind_type yykind = yysym.kind ();
+        yyo << (yykind < YYNTOKENS ? "token" : "nterm")
+            << ' ' << yysym.name () << " ("
+            << yysym.location << ": ";
+        YY_USE (yykind);
+        yyo << ')';
+      }
+  }
+#endif
+
+  void
+  conj_parser::yypush_ (const char* m, YY_MOVE_REF (stack_symbol_type) sym)
+  {
+    if (m)
+      YY_SYMBOL_PRINT (m, sym);
+    yystack_.push (YY_MOVE (sym));
+  }
+
+  void
+  conj_parser::yypush_ (const char* m, state_type s, YY_MOVE_REF (symbol_type) sym)
+  {
+#if 201103L <= YY_CPLUSPLUS
+    yypush_ (m, stack_symbol_type (s, std::move (sym)));
+#else
+    stack_symbol_type ss (s, sym);
+    yypush_ (m, ss);
+#endif
+  }
+
+  void
+  conj_parser::yypop_ (int n) YY_NOEXCEPT
+  {
+    yystack_.pop (n);
+  }
+
+#if YYDEBUG
+  std::ostream&
+  conj_parser::debug_stream () const
+  {
+    return *yycdebug_;
+  }
+
+  void
+  conj_parser::set_debug_stream (std::ostream& o)
+  {
+    yycdebug_ = &o;
+  }
+
+
+  conj_parser::debug_level_type
+  conj_parser::debug_level () const
+  {
+    return yydebug_;
+  }
+
+  void
+  conj_parser::set_debug_level (debug_level_type l)
+  {
+    yydebug_ = l;
+  }
+#endif // YYDEBUG
+
+  conj_parser::state_type
+  conj_parser::yy_lr_goto_state_ (state_type yystate, int yysym)
+  {
+    int yyr = yypgoto_[yysym - YYNTOKENS] + yystate;
+    if (0 <= yyr && yyr <= yylast_ && yycheck_[yyr] == yystate)
+      return yytable_[yyr];
+    else
+      return yydefgoto_[yysym - YYNTOKENS];
+  }
+
+  bool
+  conj_parser::yy_pact_value_is_default_ (int yyvalue) YY_NOEXCEPT
+  {
+    return yyvalue == yypact_ninf_;
+  }
+
+  bool
+  conj_parser::yy_table_value_is_error_ (int yyvalue) YY_NOEXCEPT
+  {
+    return yyvalue == yytable_ninf_;
+  }
+
+  int
+  conj_parser::operator() ()
+  {
+    return parse ();
+  }
+
+  int
+  conj_parser::parse ()
+  {
+    int yyn;
+    /// Length of the RHS of the rule being reduced.
+    int yylen = 0;
+
+    // Error handling.
+    int yynerrs_ = 0;
+    int yyerrstatus_ = 0;
+
+    /// The lookahead symbol.
+    symbol_type yyla;
+
+    /// The locations where the error started and ended.
+    stack_symbol_type yyerror_range[3];
+
+    /// The return value of parse ().
+    int yyresult;
+
+#if YY_EXCEPTIONS
+    try
+#endif // YY_EXCEPTIONS
+      {
+    YYCDEBUG << "Starting parse\n";
+
+
+    /* Initialize the stack.  The initial state will be set in
+       yynewstate, since the latter expects the semantical and the
+       location values to have been already stored, initialize these
+       stacks with a primary value.  */
+    yystack_.clear ();
+    yypush_ (YY_NULLPTR, 0, YY_MOVE (yyla));
+
+  /*-----------------------------------------------.
+  | yynewstate -- push a new symbol on the stack.  |
+  `-----------------------------------------------*/
+  yynewstate:
+    YYCDEBUG << "Entering state " << int (yystack_[0].state) << '\n';
+    YY_STACK_PRINT ();
+
+    // Accept?
+    if (yystack_[0].state == yyfinal_)
+      YYACCEPT;
+
+    goto yybackup;
+
+
+  /*-----------.
+  | yybackup.  |
+  `-----------*/
+  yybackup:
+    // Try to take a decision without lookahead.
+    yyn = yypact_[+yystack_[0].state];
+    if (yy_pact_value_is_default_ (yyn))
+      goto yydefault;
+
+    // Read a lookahead token.
+    if (yyla.empty ())
+      {
+        YYCDEBUG << "Reading a token\n";
+#if YY_EXCEPTIONS
+        try
+#endif // YY_EXCEPTIONS
+          {
+            symbol_type yylookahead (yylex (lex));
+            yyla.move (yylookahead);
+          }
+#if YY_EXCEPTIONS
+        catch (const syntax_error& yyexc)
+          {
+            YYCDEBUG << "Caught exception: " << yyexc.what() << '\n';
+            error (yyexc);
+            goto yyerrlab1;
+          }
+#endif // YY_EXCEPTIONS
+      }
+    YY_SYMBOL_PRINT ("Next token is", yyla);
+
+    if (yyla.kind () == symbol_kind::S_YYerror)
+    {
+      // The scanner already issued an error message, process directly
+      // to error recovery.  But do not keep the error token as
+      // lookahead, it is too special and may lead us to an endless
+      // loop in error recovery. */
+      yyla.kind_ = symbol_kind::S_YYUNDEF;
+      goto yyerrlab1;
+    }
+
+    /* If the proper action on seeing token YYLA.TYPE is to reduce or
+       to detect an error, take that action.  */
+    yyn += yyla.kind ();
+    if (yyn < 0 || yylast_ < yyn || yycheck_[yyn] != yyla.kind ())
+      {
+        goto yydefault;
+      }
+
+    // Reduce or error.
+    yyn = yytable_[yyn];
+    if (yyn <= 0)
+      {
+        if (yy_table_value_is_error_ (yyn))
+          goto yyerrlab;
+        yyn = -yyn;
+        goto yyreduce;
+      }
+
+    // Count tokens shifted since error; after three, turn off error status.
+    if (yyerrstatus_)
+      --yyerrstatus_;
+
+    // Shift the lookahead token.
+    yypush_ ("Shifting", state_type (yyn), YY_MOVE (yyla));
+    goto yynewstate;
+
+
+  /*-----------------------------------------------------------.
+  | yydefault -- do the default action for the current state.  |
+  `-----------------------------------------------------------*/
+  yydefault:
+    yyn = yydefact_[+yystack_[0].state];
+    if (yyn == 0)
+      goto yyerrlab;
+    goto yyreduce;
+
+
+  /*-----------------------------.
+  | yyreduce -- do a reduction.  |
+  `-----------------------------*/
+  yyreduce:
+    yylen = yyr2_[yyn];
+    {
+      stack_symbol_type yylhs;
+      yylhs.state = yy_lr_goto_state_ (yystack_[yylen].state, yyr1_[yyn]);
+      /* Variants are always initialized to an empty instance of the
+         correct type. The default '$$ = $1' action is NOT applied
+         when using variants.  */
+      switch (yyr1_[yyn])
+    {
+      case symbol_kind::S_assignment: // assignment
+        yylhs.value.emplace< Assignment* > ();
+        break;
+
+      case symbol_kind::S_lvalue: // lvalue
+        yylhs.value.emplace< Constant* > ();
+        break;
+
+      case symbol_kind::S_expression: // expression
+        yylhs.value.emplace< Expression* > ();
+        break;
+
+      case symbol_kind::S_23_expression_item: // expression-item
+      case symbol_kind::S_24_expression_block: // expression-block
+        yylhs.value.emplace< ExpressionBlock* > ();
+        break;
+
+      case symbol_kind::S_function: // function
+        yylhs.value.emplace< Function* > ();
+        break;
+
+      case symbol_kind::S_32_function_call: // function-call
+        yylhs.value.emplace< FunctionCall* > ();
+        break;
+
+      case symbol_kind::S_operation: // operation
+        yylhs.value.emplace< Operation* > ();
+        break;
+
+      case symbol_kind::S_25_return_block: // return-block
+        yylhs.value.emplace< ReturnExpression* > ();
+        break;
+
+      case symbol_kind::S_svalue: // svalue
+        yylhs.value.emplace< StringConstant* > ();
+        break;
+
+      case symbol_kind::S_variable: // variable
+        yylhs.value.emplace< Variable* > ();
+        break;
+
+      case symbol_kind::S_34_vector_item: // vector-item
+      case symbol_kind::S_vector: // vector
+        yylhs.value.emplace< Vector* > ();
+        break;
+
+      case symbol_kind::S_NUMCONST: // NUMCONST
+        yylhs.value.emplace< double > ();
+        break;
+
+      case symbol_kind::S_IDENTIFIER: // IDENTIFIER
+      case symbol_kind::S_STRINGCONST: // STRINGCONST
+        yylhs.value.emplace< std::string_view > ();
+        break;
+
+      default:
+        break;
+    }
+
+
+      // Default location.
+      {
+        stack_type::slice range (yystack_, yylen);
+        YYLLOC_DEFAULT (yylhs.location, range, yylen);
+        yyerror_range[1].location = yylhs.location;
+      }
+
+      // Perform the reduction.
+      YY_REDUCE_PRINT (yyn);
+#if YY_EXCEPTIONS
+      try
+#endif // YY_EXCEPTIONS
+        {
+          switch (yyn)
+            {
+  case 2: // library: expression
+#line 85 "/dev/stdin"
+                    {lex.root = yystack_[0].value.as < Expression* > (); }
+#line 2869 "build/expr_main.cc.re"
+    break;
+
+  case 3: // expression-item: expression
+#line 87 "/dev/stdin"
+                            {yylhs.value.as < ExpressionBlock* > () = lex.make<ExpressionBlock>(yylhs.location); yylhs.value.as < ExpressionBlock* > ()->add_expression(yystack_[0].value.as < Expression* > ()); }
+#line 2875 "build/expr_main.cc.re"
+    break;
+
+  case 4: // expression-item: expression-item ';' expression
+#line 88 "/dev/stdin"
+                                                {yylhs.value.as < ExpressionBlock* > () = lex.locate(yystack_[2].value.as < ExpressionBlock* > (),yylhs.location); yylhs.value.as < ExpressionBlock* > ()->add_expression(yystack_[0].value.as < Expression* > ()); }
+#line 2881 "build/expr_main.cc.re"
+    break;
+
+  case 5: // expression-block: '{' expression-item ';' '}'
+#line 90 "/dev/stdin"
+                                              {yylhs.value.as < ExpressionBlock* > () = lex.locate(yystack_[2].value.as < ExpressionBlock* > (),yylhs.location); }
+#line 2887 "build/expr_main.cc.re"
+    break;
+
+  case 6: // expression-block: '{' expression-item '}'
+#line 91 "/dev/stdin"
+                                          {yylhs.value.as < ExpressionBlock* > () = lex.locate(yystack_[1].value.as < ExpressionBlock* > (),yylhs.location); }
+#line 2893 "build/expr_main.cc.re"
+    break;
+
+  case 7: // expression-block: '{' '}'
+#line 92 "/dev/stdin"
+                          {yylhs.value.as < ExpressionBlock* > () = lex.make<ExpressionBlock>(yylhs.location); }
+#line 2899 "build/expr_main.cc.re"
+    break;
+
+  case 8: // return-block: "return" expression
+#line 94 "/dev/stdin"
+                                {yylhs.value.as < ReturnExpression* > () = lex.make<ReturnExpression>(yylhs.location,yystack_[0].value.as < Expression* > ()); }
+#line 2905 "build/expr_main.cc.re"
+    break;
+
+  case 9: // expression: expression-block
+#line 96 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < ExpressionBlock* > ();}
+#line 2911 "build/expr_main.cc.re"
+    break;
+
+  case 10: // expression: return-block
+#line 97 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < ReturnExpression* > ();}
+#line 2917 "build/expr_main.cc.re"
+    break;
+
+  case 11: // expression: assignment
+#line 98 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < Assignment* > ();}
+#line 2923 "build/expr_main.cc.re"
+    break;
+
+  case 12: // expression: function
+#line 99 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < Function* > ();}
+#line 2929 "build/expr_main.cc.re"
+    break;
+
+  case 13: // expression: lvalue
+#line 100 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < Constant* > ();}
+#line 2935 "build/expr_main.cc.re"
+    break;
+
+  case 14: // expression: svalue
+#line 101 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < StringConstant* > ();}
+#line 2941 "build/expr_main.cc.re"
+    break;
+
+  case 15: // expression: variable
+#line 102 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < Variable* > ();}
+#line 2947 "build/expr_main.cc.re"
+    break;
+
+  case 16: // expression: function-call
+#line 103 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < FunctionCall* > ();}
+#line 2953 "build/expr_main.cc.re"
+    break;
+
+  case 17: // expression: operation
+#line 104 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < Operation* > ();}
+#line 2959 "build/expr_main.cc.re"
+    break;
+
+  case 18: // expression: vector
+#line 105 "/dev/stdin"
+                             { yylhs.value.as < Expression* > () = yystack_[0].value.as < Vector* > ();}
+#line 2965 "build/expr_main.cc.re"
+    break;
+
+  case 19: // lvalue: NUMCONST
+#line 107 "/dev/stdin"
+                        {yylhs.value.as < Constant* > () = lex.make<Constant>(yylhs.location,yystack_[0].value.as < double > ()); }
+#line 2971 "build/expr_main.cc.re"
+    break;
+
+  case 20: // svalue: STRINGCONST
+#line 109 "/dev/stdin"
+                        {yylhs.value.as < StringConstant* > () = lex.make<StringConstant>(yylhs.location,*lex.scope,std::string(yystack_[0].value.as < std::string_view > ()));}
+#line 2977 "build/expr_main.cc.re"
+    break;
+
+  case 21: // variable: IDENTIFIER
+#line 111 "/dev/stdin"
+                     {yylhs.value.as < Variable* > () = lex.make<Variable>(yylhs.location,lex.scope->symbols,yystack_[0].value.as < std::string_view > ()); }
+#line 2983 "build/expr_main.cc.re"
+    break;
+
+  case 22: // assignment: variable '=' expression
+#line 113 "/dev/stdin"
+                                    {yylhs.value.as < Assignment* > () = lex.make<Assignment>(yylhs.location,yystack_[2].value.as < Variable* > (),yystack_[0].value.as < Expression* > ()); }
+#line 2989 "build/expr_main.cc.re"
+    break;
+
+  case 23: // function: vector expression-block
+#line 115 "/dev/stdin"
+                                  {yylhs.value.as < Function* > () = lex.make<Function>(yylhs.location,yystack_[1].value.as < Vector* > (),yystack_[0].value.as < ExpressionBlock* > ()); }
+#line 2995 "build/expr_main.cc.re"
+    break;
+
+  case 24: // function-call: variable vector
+#line 117 "/dev/stdin"
+                                  {yylhs.value.as < FunctionCall* > () = lex.make<FunctionCall>(yylhs.location,yystack_[1].value.as < Variable* > (),yystack_[0].value.as < Vector* > ()); }
+#line 3001 "build/expr_main.cc.re"
+    break;
+
+  case 25: // operation: expression '+' expression
+#line 119 "/dev/stdin"
+                                         {yylhs.value.as < Operation* > () = lex.make<Operation>(yylhs.location,yystack_[2].value.as < Expression* > (),yystack_[0].value.as < Expression* > (),op_sum); }
+#line 3007 "build/expr_main.cc.re"
+    break;
+
+  case 26: // operation: expression '-' expression
+#line 120 "/dev/stdin"
+                                         {yylhs.value.as < Operation* > () = lex.make<Operation>(yylhs.location,yystack_[2].value.as < Expression* > (),yystack_[0].value.as < Expression* > (),op_sub); }
+#line 3013 "build/expr_main.cc.re"
+    break;
+
+  case 27: // operation: expression '*' expression
+#line 121 "/dev/stdin"
+                                         {yylhs.value.as < Operation* > () = lex.make<Operation>(yylhs.location,yystack_[2].value.as < Expression* > (),yystack_[0].value.as < Expression* > (),op_mul); }
+#line 3019 "build/expr_main.cc.re"
+    break;
+
+  case 28: // operation: expression '/' expression
+#line 122 "/dev/stdin"
+                                         {yylhs.value.as < Operation* > () = lex.make<Operation>(yylhs.location,yystack_[2].value.as < Expression* > (),yystack_[0].value.as < Expression* > (),op_div); }
+#line 3025 "build/expr_main.cc.re"
+    break;
+
+  case 29: // operation: expression '^' expression
+#line 123 "/dev/stdin"
+                                         {yylhs.value.as < Operation* > () = lex.make<Operation>(yylhs.location,yystack_[2].value.as < Expression* > (),yystack_[0].value.as < Expression* > (),op_exp); }
+#line 3031 "build/expr_main.cc.re"
+    break;
+
+  case 30: // operation: expression '[' expression ']'
+#line 124 "/dev/stdin"
+                                         {yylhs.value.as < Operation* > () = lex.make<Operation>(yylhs.location,yystack_[3].value.as < Expression* > (),yystack_[1].value.as < Expression* > (),op_ref); }
+#line 3037 "build/expr_main.cc.re"
+    break;
+
+  case 31: // vector-item: expression
+#line 126 "/dev/stdin"
+                        {yylhs.value.as < Vector* > () = lex.make<Vector>(yylhs.location); yylhs.value.as < Vector* > ()->add_expression(yystack_[0].value.as < Expression* > ()); }
+#line 3043 "build/expr_main.cc.re"
+    break;
+
+  case 32: // vector-item: vector-item ',' expression
+#line 127 "/dev/stdin"
+                                        {yylhs.value.as < Vector* > () = lex.locate(yystack_[2].value.as < Vector* > (),yylhs.location); yylhs.value.as < Vector* > ()->add_expression(yystack_[0].value.as < Expression* > ()); }
+#line 3049 "build/expr_main.cc.re"
+    break;
+
+  case 33: // vector: '(' vector-item ')'
+#line 129 "/dev/stdin"
+                            {yylhs.value.as < Vector* > () = lex.locate(yystack_[1].value.as < Vector* > (),yylhs.location);}
+#line 3055 "build/expr_main.cc.re"
+    break;
+
+  case 34: // vector: '(' ')'
+#line 130 "/dev/stdin"
+                {yylhs.value.as < Vector* > () = lex.make<Vector>(yylhs.location);}
+#line 3061 "build/expr_main.cc.re"
+    break;
+
+
+#line 3065 "build/expr_main.cc.re"
+
+            default:
+              break;
+            }
+        }
+#if YY_EXCEPTIONS
+      catch (const syntax_error& yyexc)
+        {
+          YYCDEBUG << "Caught exception: " << yyexc.what() << '\n';
+          error (yyexc);
+          YYERROR;
+        }
+#endif // YY_EXCEPTIONS
+      YY_SYMBOL_PRINT ("-> $$ =", yylhs);
+      yypop_ (yylen);
+      yylen = 0;
+
+      // Shift the result of the reduction.
+      yypush_ (YY_NULLPTR, YY_MOVE (yylhs));
+    }
+    goto yynewstate;
+
+
+  /*--------------------------------------.
+  | yyerrlab -- here on detecting error.  |
+  `--------------------------------------*/
+  yyerrlab:
+    // If not already recovering from an error, report this error.
+    if (!yyerrstatus_)
+      {
+        ++yynerrs_;
+        context yyctx (*this, yyla);
+        std::string msg = yysyntax_error_ (yyctx);
+        error (yyla.location, YY_MOVE (msg));
+      }
+
+
+    yyerror_range[1].location = yyla.location;
+    if (yyerrstatus_ == 3)
+      {
+        /* If just tried and failed to reuse lookahead token after an
+           error, discard it.  */
+
+        // Return failure if at end of input.
+        if (yyla.kind () == symbol_kind::S_YYEOF)
+          YYABORT;
+        else if (!yyla.empty ())
+          {
+            yy_destroy_ ("Error: discarding", yyla);
+            yyla.clear ();
+          }
+      }
+
+    // Else will try to reuse lookahead token after shifting the error token.
+    goto yyerrlab1;
+
+
+  /*---------------------------------------------------.
+  | yyerrorlab -- error raised explicitly by YYERROR.  |
+  `---------------------------------------------------*/
+  yyerrorlab:
+    /* Pacify compilers when the user code never invokes YYERROR and
+       the label yyerrorlab therefore never appears in user code.  */
+    if (false)
+      YYERROR;
+
+    /* Do not reclaim the symbols of the rule whose action triggered
+       this YYERROR.  */
+    yypop_ (yylen);
+    yylen = 0;
+    YY_STACK_PRINT ();
+    goto yyerrlab1;
+
+
+  /*-------------------------------------------------------------.
+  | yyerrlab1 -- common code for both syntax error and YYERROR.  |
+  `-------------------------------------------------------------*/
+  yyerrlab1:
+    yyerrstatus_ = 3;   // Each real token shifted decrements this.
+    // Pop stack until we find a state that shifts the error token.
+    for (;;)
+      {
+        yyn = yypact_[+yystack_[0].state];
+        if (!yy_pact_value_is_default_ (yyn))
+          {
+            yyn += symbol_kind::S_YYerror;
+            if (0 <= yyn && yyn <= yylast_
+                && yycheck_[yyn] == symbol_kind::S_YYerror)
+              {
+                yyn = yytable_[yyn];
+                if (0 < yyn)
+                  break;
+              }
+          }
+
+        // Pop the current state because it cannot handle the error token.
+        if (yystack_.size () == 1)
+          YYABORT;
+
+        yyerror_range[1].location = yystack_[0].location;
+        yy_destroy_ ("Error: popping", yystack_[0]);
+        yypop_ ();
+        YY_STACK_PRINT ();
+      }
+    {
+      stack_symbol_type error_token;
+
+      yyerror_range[2].location = yyla.location;
+      YYLLOC_DEFAULT (error_token.location, yyerror_range, 2);
+
+      // Shift the error token.
+      error_token.state = state_type (yyn);
+      yypush_ ("Shifting", YY_MOVE (error_token));
+    }
+    goto yynewstate;
+
+
+  /*-------------------------------------.
+  | yyacceptlab -- YYACCEPT comes here.  |
+  `-------------------------------------*/
+  yyacceptlab:
+    yyresult = 0;
+    goto yyreturn;
+
+
+  /*-----------------------------------.
+  | yyabortlab -- YYABORT comes here.  |
+  `-----------------------------------*/
+  yyabortlab:
+    yyresult = 1;
+    goto yyreturn;
+
+
+  /*-----------------------------------------------------.
+  | yyreturn -- parsing is finished, return the result.  |
+  `-----------------------------------------------------*/
+  yyreturn:
+    if (!yyla.empty ())
+      yy_destroy_ ("Cleanup: discarding lookahead", yyla);
+
+    /* Do not reclaim the symbols of the rule whose action triggered
+       this YYABORT or YYACCEPT.  */
+    yypop_ (yylen);
+    YY_STACK_PRINT ();
+    while (1 < yystack_.size ())
+      {
+        yy_destroy_ ("Cleanup: popping", yystack_[0]);
+        yypop_ ();
+      }
+
+    return yyresult;
+  }
+#if YY_EXCEPTIONS
+    catch (...)
+      {
+        YYCDEBUG << "Exception caught: cleaning lookahead and stack\n";
+        // Do not try to display the values of the reclaimed symbols,
+        // as their printers might throw an exception.
+        if (!yyla.empty ())
+          yy_destroy_ (YY_NULLPTR, yyla);
+
+        while (1 < yystack_.size ())
+          {
+            yy_destroy_ (YY_NULLPTR, yystack_[0]);
+            yypop_ ();
+          }
+        throw;
+      }
+#endif // YY_EXCEPTIONS
+  }
+
+  void
+  conj_parser::error (const syntax_error& yyexc)
+  {
+    error (yyexc.location, yyexc.what ());
+  }
+
+  /* Return YYSTR after stripping away unnecessary quotes and
+     backslashes, so that it's suitable for yyerror.  The heuristic is
+     that double-quoting is unnecessary unless the string contains an
+     apostrophe, a comma, or backslash (other than backslash-backslash).
+     YYSTR is taken from yytname.  */
+  std::string
+  conj_parser::yytnamerr_ (const char *yystr)
+  {
+    if (*yystr == '"')
+      {
+        std::string yyr;
+        char const *yyp = yystr;
+
+        for (;;)
+          switch (*++yyp)
+            {
+            case '\'':
+            case ',':
+              goto do_not_strip_quotes;
+
+            case '\\':
+              if (*++yyp != '\\')
+                goto do_not_strip_quotes;
+              else
+                goto append;
+
+            append:
+            default:
+              yyr += *yyp;
+              break;
+
+            case '"':
+              return yyr;
+            }
+      do_not_strip_quotes: ;
+      }
+
+    return yystr;
+  }
+
+  std::string
+  conj_parser::symbol_name (symbol_kind_type yysymbol)
+  {
+    return yytnamerr_ (yytname_[yysymbol]);
+  }
+
+
+
+  // conj_parser::context.
+  conj_parser::context::context (const conj_parser& yyparser, const symbol_type& yyla)
+    : yyparser_ (yyparser)
+    , yyla_ (yyla)
+  {}
+
+  int
+  conj_parser::context::expected_tokens (symbol_kind_type yyarg[], int yyargn) const
+  {
+    // Actual number of expected tokens
+    int yycount = 0;
+
+    const int yyn = yypact_[+yyparser_.yystack_[0].state];
+    if (!yy_pact_value_is_default_ (yyn))
+      {
+        /* Start YYX at -YYN if negative to avoid negative indexes in
+           YYCHECK.  In other words, skip the first -YYN actions for
+           this state because they are default actions.  */
+        const int yyxbegin = yyn < 0 ? -yyn : 0;
+        // Stay within bounds of both yycheck and yytname.
+        const int yychecklim = yylast_ - yyn + 1;
+        const int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
+        for (int yyx = yyxbegin; yyx < yyxend; ++yyx)
+          if (yycheck_[yyx + yyn] == yyx && yyx != symbol_kind::S_YYerror
+              && !yy_table_value_is_error_ (yytable_[yyx + yyn]))
+            {
+              if (!yyarg)
+                ++yycount;
+              else if (yycount == yyargn)
+                return 0;
+              else
+                yyarg[yycount++] = YY_CAST (symbol_kind_type, yyx);
+            }
+      }
+
+    if (yyarg && yycount == 0 && 0 < yyargn)
+      yyarg[0] = symbol_kind::S_YYEMPTY;
+    return yycount;
+  }
+
+
+
+
+
+
+  int
+  conj_parser::yy_syntax_error_arguments_ (const context& yyctx,
+                                                 symbol_kind_type yyarg[], int yyargn) const
+  {
+    /* There are many possibilities here to consider:
+       - If this state is a consistent state with a default action, then
+         the only way this function was invoked is if the default action
+         is an error action.  In that case, don't check for expected
+         tokens because there are none.
+       - The only way there can be no lookahead present (in yyla) is
+         if this state is a consistent state with a default action.
+         Thus, detecting the absence of a lookahead is sufficient to
+         determine that there is no unexpected or expected token to
+         report.  In that case, just report a simple "syntax error".
+       - Don't assume there isn't a lookahead just because this state is
+         a consistent state with a default action.  There might have
+         been a previous inconsistent state, consistent state with a
+         non-default action, or user semantic action that manipulated
+         yyla.  (However, yyla is currently not documented for users.)
+       - Of course, the expected token list depends on states to have
+         correct lookahead information, and it depends on the parser not
+         to perform extra reductions after fetching a lookahead from the
+         scanner and before detecting a syntax error.  Thus, state merging
+         (from LALR or IELR) and default reductions corrupt the expected
+         token list.  However, the list is correct for canonical LR with
+         one exception: it will still contain any token that will not be
+         accepted due to an error action in a later state.
+    */
+
+    if (!yyctx.lookahead ().empty ())
+      {
+        if (yyarg)
+          yyarg[0] = yyctx.token ();
+        int yyn = yyctx.expected_tokens (yyarg ? yyarg + 1 : yyarg, yyargn - 1);
+        return yyn + 1;
+      }
+    return 0;
+  }
+
+  // Generate an error message.
+  std::string
+  conj_parser::yysyntax_error_ (const context& yyctx) const
+  {
+    // Its maximum.
+    enum { YYARGS_MAX = 5 };
+    // Arguments of yyformat.
+    symbol_kind_type yyarg[YYARGS_MAX];
+    int yycount = yy_syntax_error_arguments_ (yyctx, yyarg, YYARGS_MAX);
+
+    char const* yyformat = YY_NULLPTR;
+    switch (yycount)
+      {
+#define YYCASE_(N, S)                         \
+        case N:                               \
+          yyformat = S;                       \
+        break
+      default: // Avoid compiler warnings.
+        YYCASE_ (0, YY_("syntax error"));
+        YYCASE_ (1, YY_("syntax error, unexpected %s"));
+        YYCASE_ (2, YY_("syntax error, unexpected %s, expecting %s"));
+        YYCASE_ (3, YY_("syntax error, unexpected %s, expecting %s or %s"));
+        YYCASE_ (4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
+        YYCASE_ (5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
+#undef YYCASE_
+      }
+
+    std::string yyres;
+    // Argument number.
+    std::ptrdiff_t yyi = 0;
+    for (char const* yyp = yyformat; *yyp; ++yyp)
+      if (yyp[0] == '%' && yyp[1] == 's' && yyi < yycount)
+        {
+          yyres += symbol_name (yyarg[yyi++]);
+          ++yyp;
+        }
+      else
+        yyres += *yyp;
+    return yyres;
+  }
+
+
+  const signed char conj_parser::yypact_ninf_ = -5;
+
+  const signed char conj_parser::yytable_ninf_ = -1;
+
+  const signed char
+  conj_parser::yypact_[] =
+  {
+      36,    -5,    -5,    -5,    36,     0,     4,    12,    -5,    -5,
+      54,    -5,    -5,    37,    -5,    -5,    -5,    -5,    -1,    54,
+      -5,    54,    10,    -5,    26,    54,    -5,    36,    36,    36,
+      36,    36,    36,    36,    -5,    -5,    36,    -5,    32,    -5,
+      59,    59,    -3,    -3,    -2,    44,    54,    54,    -5,    54,
+      -5
+  };
+
+  const signed char
+  conj_parser::yydefact_[] =
+  {
+       0,    21,    19,    20,     0,     0,     0,     0,     9,    10,
+       2,    13,    14,    15,    11,    12,    16,    17,    18,     8,
+      34,    31,     0,     7,     0,     3,     1,     0,     0,     0,
+       0,     0,     0,     0,    24,    23,     0,    33,     0,     6,
+      25,    26,    27,    28,    29,     0,    22,    32,     5,     4,
+      30
+  };
+
+  const signed char
+  conj_parser::yypgoto_[] =
+  {
+      -5,    -5,    -5,    13,    -5,    -4,    -5,    -5,    -5,    -5,
+      -5,    -5,    -5,    -5,    30
+  };
+
+  const signed char
+  conj_parser::yydefgoto_[] =
+  {
+       0,     7,    24,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    22,    18
+  };
+
+  const signed char
+  conj_parser::yytable_[] =
+  {
+      19,    21,    25,     1,     2,     3,     4,     1,     2,     3,
+       4,    31,    26,    32,    32,     5,     6,     6,    36,     5,
+      20,     6,    23,    40,    41,    42,    43,    44,    45,    46,
+      37,    35,    47,    38,    49,     1,     2,     3,     4,     1,
+       2,     3,     4,    34,    39,     0,    33,     5,     0,     6,
+      48,     5,     5,     6,    27,    28,    29,    30,    31,     0,
+      32,     0,     0,    50,    27,    28,    29,    30,    31,     0,
+      32,    29,    30,    31,     0,    32
+  };
+
+  const signed char
+  conj_parser::yycheck_[] =
+  {
+       4,     5,     6,     3,     4,     5,     6,     3,     4,     5,
+       6,    14,     0,    16,    16,    15,    17,    17,     8,    15,
+      20,    17,    18,    27,    28,    29,    30,    31,    32,    33,
+      20,    18,    36,     7,    38,     3,     4,     5,     6,     3,
+       4,     5,     6,    13,    18,    -1,     9,    15,    -1,    17,
+      18,    15,    15,    17,    10,    11,    12,    13,    14,    -1,
+      16,    -1,    -1,    19,    10,    11,    12,    13,    14,    -1,
+      16,    12,    13,    14,    -1,    16
+  };
+
+  const signed char
+  conj_parser::yystos_[] =
+  {
+       0,     3,     4,     5,     6,    15,    17,    22,    24,    25,
+      26,    27,    28,    29,    30,    31,    32,    33,    35,    26,
+      20,    26,    34,    18,    23,    26,     0,    10,    11,    12,
+      13,    14,    16,     9,    35,    24,     8,    20,     7,    18,
+      26,    26,    26,    26,    26,    26,    26,    26,    18,    26,
+      19
+  };
+
+  const signed char
+  conj_parser::yyr1_[] =
+  {
+       0,    21,    22,    23,    23,    24,    24,    24,    25,    26,
+      26,    26,    26,    26,    26,    26,    26,    26,    26,    27,
+      28,    29,    30,    31,    32,    33,    33,    33,    33,    33,
+      33,    34,    34,    35,    35
+  };
+
+  const signed char
+  conj_parser::yyr2_[] =
+  {
+       0,     2,     1,     1,     3,     4,     3,     2,     2,     1,
+       1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     3,     2,     2,     3,     3,     3,     3,     3,
+       4,     1,     3,     3,     2
+  };
+
+
+#if YYDEBUG || 1
+  // YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+  // First, the terminals, then, starting at \a YYNTOKENS, nonterminals.
+  const char*
+  const conj_parser::yytname_[] =
+  {
+  "END", "error", "\"invalid token\"", "IDENTIFIER", "NUMCONST",
+  "STRINGCONST", "\"return\"", "';'", "','", "'='", "'+'", "'-'", "'*'",
+  "'/'", "'^'", "'('", "'['", "'{'", "'}'", "']'", "')'", "$accept",
+  "library", "expression-item", "expression-block", "return-block",
+  "expression", "lvalue", "svalue", "variable", "assignment", "function",
+  "function-call", "operation", "vector-item", "vector", YY_NULLPTR
+  };
+#endif
+
+
+#if YYDEBUG
+  const unsigned char
+  conj_parser::yyrline_[] =
+  {
+       0,    85,    85,    87,    88,    90,    91,    92,    94,    96,
+      97,    98,    99,   100,   101,   102,   103,   104,   105,   107,
+     109,   111,   113,   115,   117,   119,   120,   121,   122,   123,
+     124,   126,   127,   129,   130
+  };
+
+  void
+  conj_parser::yy_stack_print_ () const
+  {
+    *yycdebug_ << "Stack now";
+    for (stack_type::const_iterator
+           i = yystack_.begin (),
+           i_end = yystack_.end ();
+         i != i_end; ++i)
+      *yycdebug_ << ' ' << int (i->state);
+    *yycdebug_ << '\n';
+  }
+
+  void
+  conj_parser::yy_reduce_print_ (int yyrule) const
+  {
+    int yylno = yyrline_[yyrule];
+    int yynrhs = yyr2_[yyrule];
+    // Print the symbols being reduced, and their result.
+    *yycdebug_ << "Reducing stack by rule " << yyrule - 1
+               << " (line " << yylno << "):\n";
+    // The symbols being reduced.
+    for (int yyi = 0; yyi < yynrhs; yyi++)
+      YY_SYMBOL_PRINT ("   $" << yyi + 1 << " =",
+                       yystack_[(yynrhs) - (yyi + 1)]);
+  }
+#endif // YYDEBUG
+
+
+} // yy
+#line 3568 "build/expr_main.cc.re"
+
+#line 132 "/dev/stdin"
+
+
+//The pattern already checked the syntax, the number is read in place
+static double parse_number(const char* begin,const char* end)
+{
+    double value = 0;
+    std::from_chars(begin,end,value);
+    return value;
+}
+
+yy::conj_parser::symbol_type yy::yylex(lexcontext &ctx)
+{
+    //Whitespace and comments go around the loop, everything else returns a token
+    for (;;)
+    {
+        const char* anchor = ctx.cursor;
+        ctx.loc.step();
+        auto s = [&](auto func, auto&&... params) { ctx.loc.columns(ctx.cursor - anchor); return func(params..., ctx.loc); };
+
+        {
+    static const std::regex fake_re2c_rules[] = {
+        std::regex(std::string("(?:return)", 10), std::regex::ECMAScript),
+        std::regex(std::string("(?:[a-zA-Z_][a-zA-Z_0-9]*)", 26), std::regex::ECMAScript),
+        std::regex(std::string("(?:\\\"[^\\\"]*\\\")", 14), std::regex::ECMAScript),
+        std::regex(std::string("(?:[0-9]+)", 10), std::regex::ECMAScript),
+        std::regex(std::string("(?:[0-9]*\\.[0-9]+)", 18), std::regex::ECMAScript),
+        std::regex(std::string("(?:[0-9]+\\.[0-9]*)", 18), std::regex::ECMAScript),
+        std::regex(std::string("(?:\\x00)", 8), std::regex::ECMAScript),
+        std::regex(std::string("(?:\\r\\n|[\\r\\n])", 15), std::regex::ECMAScript),
+        std::regex(std::string("(?:\\/\\/[^\\r\\n]*)", 16), std::regex::ECMAScript),
+        std::regex(std::string("(?:[\\t\\x0b\\x08\\x0c ]+)", 22), std::regex::ECMAScript),
+        std::regex(std::string("(?:[^\\n])", 9), std::regex::ECMAScript),
+    };
+    const char* fake_begin = ctx.cursor;
+    const char* fake_end = fake_begin + std::char_traits<char>::length(fake_begin) + 1;
+    long fake_best = -1; int fake_rule = -1;
+    for (int fr = 0; fr < 11; fr++) {
+        std::cmatch fm;
+        if (std::regex_search(fake_begin, fake_end, fm, fake_re2c_rules[fr], std::regex_constants::match_continuous) && fm.length(0) > fake_best && fm.length(0) > 0) { fake_best = fm.length(0); fake_rule = fr; }
+    }
+    ctx.cursor = fake_begin + fake_best;
+    switch (fake_rule) {
+    case 0: { return s(conj_parser::make_RETURN); }
+    case 1: { return s(conj_parser::make_IDENTIFIER, std::string_view(anchor,ctx.cursor - anchor)); }
+    case 2: { return s(conj_parser::make_STRINGCONST, std::string_view(anchor + 1,ctx.cursor - anchor - 2)); }
+    case 3: { return s(conj_parser::make_NUMCONST, parse_number(anchor,ctx.cursor)); }
+    case 4: { return s(conj_parser::make_NUMCONST, parse_number(anchor,ctx.cursor)); }
+    case 5: { return s(conj_parser::make_NUMCONST, parse_number(anchor,ctx.cursor)); }
+    case 6: { return s(conj_parser::make_END); }
+    case 7: { ctx.loc.lines();   continue; }
+    case 8: {                    continue; }
+    case 9: { ctx.loc.columns(ctx.cursor - anchor); continue; }
+    case 10: { return s([](auto...s){return conj_parser::symbol_type(s...);}, conj_parser::token_type(ctx.cursor[-1]&0xFF)); }
+    }
+}
+ /* End lexer */
+    }
+}
+
+void yy::conj_parser::error(const location_type& l, const std::string& m)
+{
+    std::cerr << (l.begin.filename ? l.begin.filename->c_str() : "(undefined)");
+    std::cerr << ':' << l.begin.line << ':' << l.begin.column << '-' << l.end.column << ": " << m << '\n';
+}
+
+//Parses NUL terminated code, nullptr on a syntax error
+static Expression* parse_text(const char* code,const string& filename,Scope& scope)
+{
+    lexcontext ctx;
+    ctx.cursor = code;
+    ctx.loc.begin.filename = &filename;
+    ctx.loc.end.filename   = &filename;
+    ctx.scope = &scope;
+
+    yy::conj_parser parser(ctx);
+    parser.parse();
+    return ctx.root;
+}
+
+Expression* parse_tree(const string& code, Scope& scope)
+{
+    const string filename = "<input>";
+    return parse_text(code.c_str(),filename,scope);
+}
+
+//Parses code into scope, which becomes the current scope
+void parse_document(const string& code, Scope& scope)
+{
+    Expression* root = parse_tree(code,scope);
+    if (root) scope.set_root_expression(root);
+}
+
+void parse_file(const string& path, Scope& scope)
+{
+    MappedFile source(path);
+    scope.sourceName = path;
+    uint64_t hash = 0;
+    string cache;
+    if (!scope.cacheDirectory.empty())
+    {
+        hash = content_hash(source.data(),source.size());
+        cache = ast_cache_path(scope.cacheDirectory,hash);
+        if (Expression* root = load_ast(cache,hash,source.size(),scope))
+        {
+            scope.set_root_expression(root);
+            return;
+        }
+    }
+
+    Expression* root = parse_text(source.data(),path,scope);
+    if (root == nullptr) return;
+    //Stored before name resolution and optimization change the tree
+    if (!cache.empty()) store_ast(cache,hash,source.size(),root);
+    scope.set_root_expression(root);
+}
+
+//Initialize scope so it can be reused
+int parse_to_latex(const string& code, string& result)
+{
+    OutputSink out(result);
+    return parse_to_latex(code,out);
+}
+
+int parse_to_latex(const string& code, OutputSink& out)
+{
+    Scope scope;
+    parse_document(code,scope);
+    
+    render_document(scope,out);
+    out.flush();
+    return 0;
+}
+#include <cstring>
+#include "server.h"
+#include "profile.h"
+#include <fcntl.h>
+//Usage: expr [--tree | --vm | --check | --profile] file
+//       expr --serve [socket]
+//Without options the document is translated to latex, otherwise it is evaluated
+//with the tree walker, the bytecode vm or both and the results compared.
+//--profile evaluates with the tree walker, prints the time and memory per node and function to stderr
+//and writes the stacks for flamegraph.pl to file.folded
+//--serve answers framed documents from stdin, or from the connections to a Unix socket, see server.h
+//EXPRESS_MEMO=<entries> memoizes pure functions in the tree walker and reports the cache use
+//EXPRESS_THREADS=<threads> sets the threads the tree walker evaluates independent work with
+//EXPRESS_CACHE=<directory> keeps the parsed documents there, unchanged files are not parsed again
+//EXPRESS_NATIVE=<directory> compiles pure numeric functions with g++ and keeps the objects there
+static int run(int argc, char** argv)
+{
+    if (std::string(argv[1]) == "--serve")
+    {
+        if (argc > 2) return serve_socket(argv[2]);
+        serve(STDIN_FILENO,STDOUT_FILENO);
+        return 0;
+    }
+
+    std::string option = argc > 2 ? argv[1] : "";
+    std::string filename = argv[argc - 1];
+
+    Scope scope;
+    parse_file(filename,scope);
+    //The parser reported where the syntax is wrong
+    if (scope.rootExpression == nullptr)
+    {
+        cerr << filename << ": not parsed, nothing is evaluated" << endl;
+        return 1;
+    }
+    #ifdef DEBUG
+    string prefix;
+    debug_print_expression(scope.rootExpression,prefix);
+    #endif
+
+    if (option == "--tree" || option == "--vm")
+    {
+        scope.mode = option == "--vm" ? eval_bytecode : eval_tree;
+        cout << scope.evaluate() << endl;
+        for (Function* function : scope.pureFunctions)
+        {
+            if (function->cache == nullptr) continue;
+            cerr << "memo " << (function->symbol >= 0 ? scope.symbols.name(function->symbol) : "<anonymous>");
+            cerr << ": " << function->cache->hits << " hits, " << function->cache->misses << " misses" << endl;
+        }
+        return 0;
+    }
+    if (option == "--profile")
+    {
+        Profiler* profiler = start_profile(scope);
+        Value result = scope.evaluate();
+        finish_profile(scope,profiler);
+        cout << result << endl;
+        {
+            OutputSink report(STDERR_FILENO);
+            write_profile(profiler,report);
+        }
+        std::string folded = filename + ".folded";
+        int fd = ::open(folded.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+        if (fd < 0)
+        {
+            cerr << "Cannot write " << folded << endl;
+            release_profiler(profiler);
+            return 1;
+        }
+        {
+            OutputSink stacks(fd);
+            write_folded_stacks(profiler,stacks);
+        }
+        ::close(fd);
+        release_profiler(profiler);
+        return 0;
+    }
+    if (option == "--check")
+    {
+        Value tree = scope.evaluate();
+        scope.mode = eval_bytecode;
+        Value vm = scope.evaluate();
+        cout << tree << endl << vm << endl;
+        if (tree != vm)
+        {
+            cerr << "Bytecode result differs from the tree walker" << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    OutputSink out(STDOUT_FILENO);
+    render_document(scope,out);
+    out += '\n';
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: expr [--tree | --vm | --check | --profile] file" << endl;
+        cerr << "       expr --serve [socket]" << endl;
+        return 1;
+    }
+    //Files that can not be read, sockets that can not be served and documents the vm does not compile
+    try { return run(argc,argv); }
+    catch (const std::runtime_error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
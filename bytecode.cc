@@ -0,0 +1,483 @@
+#include "bytecode.h"
+#include "expression_types.h"
+#include <set>
+#include <stdexcept>
+
+struct Compiler
+{
+    struct FunctionScope
+    {
+        int chunk;
+        std::vector<Layout> blocks;                    //Symbol to local slot
+        std::vector<std::vector<size_t>> returns;      //Pending return jumps per block
+        FunctionScope* parent;
+    };
+
+    Program& program;
+    Scope& document;                    //Resolves the names the document does not define
+    FunctionScope* current = nullptr;
+    std::set<int> defined;              //Names assigned or taken as parameters anywhere in the document
+
+    Compiler(Program& _program,Scope& _document) : program(_program), document(_document) { }
+
+    Chunk& chunk() { return program.chunks[current->chunk]; }
+
+    size_t emit(OpCode op,int a = 0,int b = 0,int c = 0)
+    {
+        chunk().code.push_back({op,a,b,c});
+        return chunk().code.size() - 1;
+    }
+
+    int constant(const Value& v)
+    {
+        program.constants.push_back(v);
+        return program.constants.size() - 1;
+    }
+
+    int name(const std::string& n)
+    {
+        program.names.push_back(n);
+        return program.names.size() - 1;
+    }
+
+    int declare(int symbol)
+    {
+        auto& block = current->blocks.back();
+        auto it = block.find(symbol);
+        if (it != block.end()) return it->second;
+        return block[symbol] = chunk().locals++;
+    }
+
+    bool lookup(int symbol,int& depth,int& slot)
+    {
+        depth = 0;
+        for (FunctionScope* f = current; f != nullptr; f = f->parent, depth++)
+        {
+            for (auto it = f->blocks.rbegin(); it != f->blocks.rend(); ++it)
+            {
+                auto found = it->find(symbol);
+                if (found != it->end()) { slot = found->second; return true; }
+            }
+        }
+        return false;
+    }
+
+    void unsupported(Expression* expression)
+    {
+        throw std::runtime_error(std::string("Bytecode: unsupported expression ") + literalType(expression));
+    }
+
+    void collect_definitions(Expression* expression)
+    {
+        if (expression->getType() == ex_Assignment) defined.insert(static_cast<Assignment*>(expression)->identifier->symbol);
+        if (expression->getType() == ex_Function)
+        {
+            Vector* parameters = static_cast<Function*>(expression)->parameterVector;
+            for (size_t i = 0; i < parameters->size(); i++) defined.insert(static_cast<Variable*>(parameters->at(i))->symbol);
+        }
+        for (Expression* e : expression->dependencies) collect_definitions(e);
+    }
+
+    //The tree walker finds a name that is not visible lexically in the callers, slots can not
+    void not_lexical(int symbol)
+    {
+        if (defined.count(symbol)) throw std::runtime_error("Bytecode: " + document.symbols.name(symbol) + " is only bound in a caller");
+    }
+
+    void compile_variable(int symbol)
+    {
+        int depth, slot;
+        if (lookup(symbol,depth,slot)) { emit(bc_load,depth,slot,name(document.symbols.name(symbol))); return; }
+
+        Binding* binding = document.find_binding(symbol);
+        Expression* global = binding ? binding->expression : nullptr;
+        if (global == nullptr)
+        {
+            not_lexical(symbol);
+            emit(bc_undefined,name(document.symbols.name(symbol)));
+        }
+        else if (global->getType() == ex_Constant) emit(bc_const,constant(static_cast<Constant*>(global)->v));
+        else unsupported(global);
+    }
+
+    void compile_string(StringConstant* expression)
+    {
+        StringTemplate t;
+        t.segments.emplace_back();
+        for (const StringConstant::Segment& segment : expression->segments)
+        {
+            t.segments.back() += segment.text;
+            if (segment.variable == nullptr) continue;
+            compile_variable(segment.variable->symbol);
+            t.segments.emplace_back();
+        }
+        program.templates.push_back(t);
+        emit(bc_string,program.templates.size() - 1);
+    }
+
+    void compile_call(FunctionCall* call)
+    {
+        int symbol = call->functionIdentifier->symbol;
+        Vector* arguments = call->valueVector;
+        int depth, slot;
+        if (lookup(symbol,depth,slot))
+        {
+            //Arguments are read by the callee, in the frame of the call
+            std::vector<Thunk> thunks;
+            for (size_t i = 0; i < arguments->size(); i++) thunks.push_back(compile_thunk(arguments->at(i),call->functionIdentifier->name));
+            program.calls.push_back(std::move(thunks));
+            emit(bc_call,depth,slot,program.calls.size() - 1);
+            return;
+        }
+
+        Binding* binding = document.find_binding(symbol);
+        Expression* global = binding ? binding->expression : nullptr;
+        if (global == nullptr)
+        {
+            not_lexical(symbol);
+            emit(bc_undefined,name(document.symbols.name(symbol)));
+            return;
+        }
+        if (global->getType() != ex_InternalFunction) unsupported(global);
+
+        InternalFunction* builtin = static_cast<InternalFunction*>(global);
+        if (builtin->is_expression_function()) unsupported(call);
+
+        compile(arguments->at(0));
+        program.builtins.push_back(builtin);
+        emit(bc_call_builtin,program.builtins.size() - 1);
+    }
+
+    //The body of a function shares the block its parameters are declared in
+    void compile_block(ExpressionBlock* block,bool body = false)
+    {
+        if (!body) current->blocks.emplace_back();
+        current->returns.emplace_back();
+        //Every name the block defines has its slot before the first statement, they can be read before they are assigned
+        for (auto& entry : block->layout) declare(entry.first);
+
+        bool pushed = false;
+        for (size_t i = 0; i < block->expressions.size(); i++)
+        {
+            Expression* expression = block->expressions[i];
+            //Only the value of the last statement is needed, assignments before it stay thunks
+            if (expression->getType() == ex_Assignment && i + 1 < block->expressions.size())
+            {
+                compile_assignment(static_cast<Assignment*>(expression),false);
+                continue;
+            }
+            if (pushed) emit(bc_pop);
+            compile(expression);
+            pushed = true;
+        }
+        if (!pushed) emit(bc_const,constant(Value()));
+
+        for (size_t jump : current->returns.back()) chunk().code[jump].a = chunk().code.size();
+        current->returns.pop_back();
+        if (!body) current->blocks.pop_back();
+    }
+
+    int compile_function(Function* function,const std::string& n)
+    {
+        program.chunks.emplace_back();
+        int index = program.chunks.size() - 1;
+        program.chunks[index].name = n;
+
+        FunctionScope scope { index, {}, {}, current };
+        current = &scope;
+        current->blocks.emplace_back();
+        for (size_t i = 0; i < function->parameterVector->size(); i++)
+        {
+            declare(static_cast<Variable*>(function->parameterVector->at(i))->symbol);
+        }
+        chunk().parameters = function->parameterVector->size();
+        compile_block(function->expressionBlock,true);
+        emit(bc_return);
+        current = scope.parent;
+        return index;
+    }
+
+    //Chunk of an assigned value or of an argument, nested in the current function so it reads its names
+    Thunk compile_thunk(Expression* expression,const std::string& n)
+    {
+        Thunk thunk;
+        if (expression->getType() == ex_Constant)
+        {
+            thunk.constant = constant(static_cast<Constant*>(expression)->v);
+            return thunk;
+        }
+        program.chunks.emplace_back();
+        thunk.chunk = program.chunks.size() - 1;
+        program.chunks[thunk.chunk].name = n;
+
+        FunctionScope scope { thunk.chunk, {}, {}, current };
+        current = &scope;
+        current->blocks.emplace_back();
+        current->returns.emplace_back();
+        compile(expression);
+        for (size_t jump : current->returns.back()) chunk().code[jump].a = chunk().code.size();
+        emit(bc_return);
+        current = scope.parent;
+        return thunk;
+    }
+
+    //Binds the name in the block that defines it, value pushes what the name reads afterwards
+    void compile_assignment(Assignment* assignment,bool value)
+    {
+        Variable* identifier = assignment->identifier;
+        int depth, slot;
+        if (!lookup(identifier->symbol,depth,slot))
+        {
+            depth = 0;
+            slot = declare(identifier->symbol);
+        }
+        if (assignment->assignment->getType() == ex_Function)
+        {
+            int function = compile_function(static_cast<Function*>(assignment->assignment),identifier->name);
+            emit(bc_closure,depth,slot,function);
+        }
+        else
+        {
+            program.thunks.push_back(compile_thunk(assignment->assignment,identifier->name));
+            emit(bc_bind,depth,slot,program.thunks.size() - 1);
+        }
+        if (value) emit(bc_load,depth,slot,name(identifier->name));
+    }
+
+    void compile(Expression* expression)
+    {
+        switch(expression->getType())
+        {
+            case ex_Constant:
+                emit(bc_const,constant(static_cast<Constant*>(expression)->v));
+                break;
+            case ex_StringConstant:
+                compile_string(static_cast<StringConstant*>(expression));
+                break;
+            case ex_Variable:
+                compile_variable(static_cast<Variable*>(expression)->symbol);
+                break;
+            case ex_Assignment:
+                compile_assignment(static_cast<Assignment*>(expression),true);
+                break;
+            case ex_Vector:
+            {
+                Vector* vector = static_cast<Vector*>(expression);
+                for (size_t i = 0; i < vector->size(); i++) compile(vector->at(i));
+                emit(bc_vector,vector->size());
+                break;
+            }
+            case ex_Operation:
+            {
+                Operation* operation = static_cast<Operation*>(expression);
+                compile(operation->a);
+                compile(operation->b);
+                switch(operation->op_type)
+                {
+                    case op_sum: emit(bc_sum); break;
+                    case op_sub: emit(bc_sub); break;
+                    case op_mul: emit(bc_mul); break;
+                    case op_div: emit(bc_div); break;
+                    case op_exp: emit(bc_exp); break;
+                    case op_ref: emit(bc_ref); break;
+                }
+                break;
+            }
+            case ex_ReturnExpression:
+                compile(static_cast<ReturnExpression*>(expression)->returnValue);
+                current->returns.back().push_back(emit(bc_jump));
+                break;
+            case ex_ExpressionBlock:
+                compile_block(static_cast<ExpressionBlock*>(expression));
+                break;
+            case ex_Function:
+                emit(bc_const,constant(Value::empty_vector()));
+                break;
+            case ex_FunctionCall:
+                compile_call(static_cast<FunctionCall*>(expression));
+                break;
+            default:
+                unsupported(expression);
+        }
+    }
+};
+
+Program compile_program(Expression* root,Scope& document)
+{
+    Program program;
+    program.chunks.emplace_back();
+    program.chunks[0].name = "<document>";
+
+    Compiler compiler(program,document);
+    compiler.collect_definitions(root);
+    Compiler::FunctionScope scope { 0, {}, {}, nullptr };
+    compiler.current = &scope;
+    scope.blocks.emplace_back();
+    scope.returns.emplace_back();
+
+    compiler.compile(root);
+    for (size_t jump : scope.returns.back()) compiler.chunk().code[jump].a = compiler.chunk().code.size();
+    compiler.emit(bc_return);
+    return program;
+}
+
+void Program::disassemble(std::ostream& os) const
+{
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        const Chunk& chunk = chunks[i];
+        os << i << ": " << chunk.name << " (" << chunk.parameters << " parameters, " << chunk.locals << " locals)" << endl;
+        for (size_t ip = 0; ip < chunk.code.size(); ip++)
+        {
+            const Instruction& in = chunk.code[ip];
+            os << "\t" << ip << "\t" << OpCodeLiterals[in.op] << " " << in.a << " " << in.b << " " << in.c;
+            if (in.op == bc_const) os << "\t; " << constants[in.a];
+            if (in.op == bc_undefined) os << "\t; " << names[in.a];
+            if (in.op == bc_load) os << "\t; " << names[in.c];
+            os << endl;
+        }
+    }
+}
+
+VirtualMachine::Slot& VirtualMachine::slot(int depth,int index)
+{
+    int frame = frames.size() - 1;
+    while (depth-- > 0) frame = frames[frame].parent;
+    return slots[frames[frame].base + index];
+}
+
+void VirtualMachine::push_frame(int chunk,int parent)
+{
+    const Chunk* c = &program.chunks[chunk];
+    frames.push_back({c,0,slots.size(),parent});
+    slots.resize(slots.size() + c->locals);
+}
+
+void VirtualMachine::bind(Slot& s,const Thunk& thunk,int environment)
+{
+    s.bound = true;
+    s.function = -1;
+    s.thunk = thunk.chunk;
+    s.environment = environment;
+    s.epoch = 0;
+    if (thunk.constant >= 0) s.value = program.constants[thunk.constant];
+}
+
+static void undefined(const std::string& name)
+{
+    cerr << "Variable " << name << " not found in any scope" << endl;
+    throw std::runtime_error("Variable not found");
+}
+
+Value VirtualMachine::run()
+{
+    stack.clear();
+    slots.clear();
+    frames.clear();
+    push_frame(0,-1);
+
+    while (true)
+    {
+        Frame& frame = frames.back();
+        const Instruction& in = frame.chunk->code[frame.ip++];
+
+        #define case_operation(type,operatort) case type: { Value r = std::move(stack.back()); stack.pop_back(); stack.back() operatort r; break; }
+        switch(in.op)
+        {
+            case bc_const: stack.push_back(program.constants[in.a]); break;
+            case bc_load:
+            {
+                Slot& s = slot(in.a,in.b);
+                if (!s.bound) undefined(program.names[in.c]);
+                if (s.thunk < 0 || s.epoch == epoch) { stack.push_back(s.value); break; }
+                //Runs the thunk, its return pushes the value and keeps it while nothing is assigned
+                long forcing = &s - slots.data();
+                push_frame(s.thunk,s.environment);
+                frames.back().forcing = forcing;
+                frames.back().epoch = epoch;
+                break;
+            }
+            case bc_bind:
+                bind(slot(in.a,in.b),program.thunks[in.c],frames.size() - 1);
+                epoch++;
+                break;
+            case bc_closure:
+            {
+                Slot& s = slot(in.a,in.b);
+                s.bound = true;
+                s.value = Value::empty_vector();
+                s.function = in.c;
+                s.thunk = -1;
+                s.environment = frames.size() - 1;
+                epoch++;
+                break;
+            }
+            case bc_pop: stack.pop_back(); break;
+            case_operation(bc_sum,+=);
+            case_operation(bc_sub,-=);
+            case_operation(bc_mul,*=);
+            case_operation(bc_div,/=);
+            case_operation(bc_exp,^=);
+            case bc_ref:
+            {
+                Value r = std::move(stack.back()); stack.pop_back();
+                stack.back() = Value(stack.back()[r[0]]);
+                break;
+            }
+            case bc_vector:
+            {
+                if (in.a == 1) break;
+                Value values = Value::empty_vector();
+                for (size_t i = stack.size() - in.a; i < stack.size(); i++) values.push_back(stack[i][0]);
+                stack.resize(stack.size() - in.a);
+                stack.push_back(std::move(values));
+                break;
+            }
+            case bc_string:
+            {
+                const StringTemplate& t = program.templates[in.a];
+                size_t first = stack.size() - (t.segments.size() - 1);
+                std::string result = t.segments[0];
+                for (size_t i = 1; i < t.segments.size(); i++)
+                {
+                    result += stack[first + i - 1];
+                    result += t.segments[i];
+                }
+                stack.resize(first);
+                stack.push_back(Value(result));
+                break;
+            }
+            case bc_call:
+            {
+                const Slot& s = slot(in.a,in.b);
+                const std::vector<Thunk>& arguments = program.calls[in.c];
+                if (s.function < 0) throw std::runtime_error("Bytecode: called value is not a function");
+                if (program.chunks[s.function].parameters != (int)arguments.size()) throw std::runtime_error("Bytecode: wrong number of arguments for " + program.chunks[s.function].name);
+
+                int caller = frames.size() - 1;
+                push_frame(s.function,s.environment);
+                size_t base = frames.back().base;
+                for (size_t i = 0; i < arguments.size(); i++) bind(slots[base + i],arguments[i],caller);
+                break;
+            }
+            case bc_call_builtin: stack.back() = program.builtins[in.a]->apply(stack.back()); break;
+            case bc_jump: frame.ip = in.a; break;
+            case bc_return:
+            {
+                long forcing = frame.forcing;
+                unsigned started = frame.epoch;
+                slots.resize(frame.base);
+                frames.pop_back();
+                if (frames.empty()) return stack.back();
+                if (forcing >= 0 && started == epoch)
+                {
+                    slots[forcing].value = stack.back();
+                    slots[forcing].epoch = epoch;
+                }
+                break;
+            }
+            case bc_undefined: undefined(program.names[in.a]);
+        }
+        #undef case_operation
+    }
+}
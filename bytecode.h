@@ -0,0 +1,133 @@
+#pragma once
+#include "global.h"
+#include "value.h"
+#include <vector>
+#include <string>
+#include <map>
+
+struct Expression;
+struct InternalFunction;
+struct Scope;
+
+/*
+    Stack based bytecode for Express.
+    The compiler lowers a parsed Expression tree into flat chunks (one per function body plus
+    the document itself) that are executed by a single dispatch loop. Variables are bound to
+    frame slots at compile time using lexical scoping and every function body is compiled
+    exactly once, no matter how many times it is called.
+    Assigned values and call arguments are thunks like in the tree walker: small chunks run
+    when the name is first read, in the frame they were written in, whose value is kept
+    until the next assignment.
+    The tree walker (Expression::evaluate) is kept as the reference implementation.
+*/
+
+#define OPCODE_ENUM(o) \
+    o(bc_const)        /* push constants[a]                                    */ \
+    o(bc_load)         /* push slot b of the frame a static links up, names[c] */ \
+    o(bc_bind)         /* bind thunks[c] to slot b of the frame a links up     */ \
+    o(bc_closure)      /* bind function c to slot b of the frame a links up    */ \
+    o(bc_pop)          /* discard top                                          */ \
+    o(bc_sum) \
+    o(bc_sub) \
+    o(bc_mul) \
+    o(bc_div) \
+    o(bc_exp) \
+    o(bc_ref) \
+    o(bc_vector)       /* pop a values and push them as a single vector        */ \
+    o(bc_string)       /* pop the values of template a and push its string     */ \
+    o(bc_call)         /* call closure in slot b of frame a links up, calls[c] */ \
+    o(bc_call_builtin) /* apply builtins[a] to top                             */ \
+    o(bc_jump)         /* ip = a                                               */ \
+    o(bc_return)       /* leave current function with top as result            */ \
+    o(bc_undefined)    /* raise a variable not found error for names[a]        */
+
+#define o(n) n,
+enum OpCode { OPCODE_ENUM(o) };
+#undef o
+
+#define o(n) #n,
+static const char* OpCodeLiterals[] = { OPCODE_ENUM(o) };
+#undef o
+
+struct Instruction
+{
+    OpCode op;
+    int a;
+    int b;
+    int c;
+};
+
+struct StringTemplate
+{
+    //Literal text between interpolated variables, segments.size() == variables + 1
+    std::vector<std::string> segments;
+};
+
+//Value of an assignment or of an argument: a chunk run on first use, or a constant
+struct Thunk
+{
+    int chunk = -1;
+    int constant = -1;
+};
+
+struct Chunk
+{
+    std::vector<Instruction> code;
+    int parameters = 0;
+    int locals = 0;
+    std::string name;
+};
+
+struct Program
+{
+    std::vector<Chunk> chunks;              //chunks[0] is the document itself
+    std::vector<Value> constants;
+    std::vector<InternalFunction*> builtins;
+    std::vector<StringTemplate> templates;
+    std::vector<std::string> names;
+    std::vector<Thunk> thunks;
+    std::vector<std::vector<Thunk>> calls;  //Arguments of every call
+
+    void disassemble(std::ostream& os) const;
+};
+
+//Throws std::runtime_error if the tree uses a construct the bytecode can not express
+Program compile_program(Expression* root,Scope& document);
+
+struct VirtualMachine
+{
+    struct Slot
+    {
+        Value value;
+        bool bound = false;
+        int function = -1;          //Chunk index when the slot holds a function
+        int thunk = -1;             //Chunk index when the value is computed on use
+        int environment = -1;       //Frame the function or thunk was defined in
+        unsigned epoch = 0;         //Epoch the value of the thunk was computed in, 0 when never
+    };
+
+    struct Frame
+    {
+        const Chunk* chunk;
+        size_t ip;
+        size_t base;                //First slot of this frame in slots
+        int parent;                 //Frame of the lexically enclosing function
+        long forcing = -1;          //Slot the result is kept in when the frame runs a thunk
+        unsigned epoch = 0;         //Epoch the thunk started in
+    };
+
+    const Program& program;
+    std::vector<Value> stack;
+    std::vector<Slot> slots;
+    std::vector<Frame> frames;
+    unsigned epoch = 1;             //Bumped by every binding, as Scope::epoch
+
+    VirtualMachine(const Program& _program) : program(_program) { }
+
+    Value run();
+
+    private:
+    Slot& slot(int depth,int index);
+    void push_frame(int chunk,int parent);
+    void bind(Slot& s,const Thunk& thunk,int environment);
+};
@@ -8,6 +8,7 @@
 %locations   // <--
 %code requires
 {
+#include <string_view>
 #include <value.h>
 #include <expression.h>
 #include <expression_types.h>
@@ -19,11 +20,31 @@ struct lexcontext;
 %param {lexcontext& lex }
 %code
 {
+#include <charconv>
+#include "ast_cache.h"
+#include "mapped_file.h"
 struct lexcontext
 {
     const char* cursor;
     const char* marker;
     yy::location loc;
+    Scope* scope;                       //Document being parsed
+    Expression* root = nullptr;         //Set once the whole document is parsed
+
+    //Nodes live in the arena of the document and are released with its Scope
+    template <typename T,typename ... Args>
+    T* make(const yy::location& loc,Args&& ... args) { return locate(scope->arena.make<T>(std::forward<Args>(args)...),loc); }
+
+    //Node spans the text of loc, for error messages and profiles
+    template <typename T>
+    T* locate(T* node,const yy::location& loc)
+    {
+        node->span.line = loc.begin.line;
+        node->span.column = loc.begin.column;
+        node->span.endLine = loc.end.line;
+        node->span.endColumn = loc.end.column;
+        return node;
+    }
 };
 namespace yy { conj_parser::symbol_type yylex(lexcontext& ctx); }
 }
@@ -43,7 +64,8 @@ namespace yy { conj_parser::symbol_type yylex(lexcontext& ctx); }
 %left  '{'
 
 
-%type<Value> NUMCONST STRINGCONST IDENTIFIER
+%type<double> NUMCONST
+%type<std::string_view> STRINGCONST IDENTIFIER
 %type<Expression*> expression
 %type<Constant*> lvalue
 %type<StringConstant*> svalue
@@ -60,16 +82,16 @@ namespace yy { conj_parser::symbol_type yylex(lexcontext& ctx); }
 
 %%
 
-library: expression {Scope::scope->set_root_expression($1); }
+library: expression {lex.root = $1; }
 
-expression-item: expression {$$ = new ExpressionBlock(); $$->add_expression($1); }
-               | expression-item ';' expression {$$ = $1; $$->add_expression($3); }
+expression-item: expression {$$ = lex.make<ExpressionBlock>(@$); $$->add_expression($1); }
+               | expression-item ';' expression {$$ = lex.locate($1,@$); $$->add_expression($3); }
 
-expression-block: '{' expression-item ';' '}' {$$ = $2; }
-                | '{' expression-item '}' {$$ = $2; }
-                | '{' '}' {$$ = new ExpressionBlock(); } 
+expression-block: '{' expression-item ';' '}' {$$ = lex.locate($2,@$); }
+                | '{' expression-item '}' {$$ = lex.locate($2,@$); }
+                | '{' '}' {$$ = lex.make<ExpressionBlock>(@$); } 
 
-return-block: RETURN expression {$$ = new ReturnExpression($2); }
+return-block: RETURN expression {$$ = lex.make<ReturnExpression>(@$,$2); }
 
 expression: expression-block { $$ = $1;}
           | return-block     { $$ = $1;}
@@ -82,38 +104,49 @@ expression: expression-block { $$ = $1;}
           | operation        { $$ = $1;}
           | vector           { $$ = $1;}
 
-lvalue: NUMCONST        {$$ = new Constant($1); }
+lvalue: NUMCONST        {$$ = lex.make<Constant>(@$,$1); }
 
-svalue: STRINGCONST     {$$ = new StringConstant($1);}
+svalue: STRINGCONST     {$$ = lex.make<StringConstant>(@$,*lex.scope,std::string($1));}
 
-variable: IDENTIFIER {$$ = new Variable($1); }
+variable: IDENTIFIER {$$ = lex.make<Variable>(@$,lex.scope->symbols,$1); }
 
-assignment: variable '=' expression {$$ = new Assignment($1,$3); }
+assignment: variable '=' expression {$$ = lex.make<Assignment>(@$,$1,$3); }
 
-function: vector expression-block {$$ = new Function($1,$2); }
+function: vector expression-block {$$ = lex.make<Function>(@$,$1,$2); }
 
-function-call: variable vector    {$$ = new FunctionCall($1,$2); }
+function-call: variable vector    {$$ = lex.make<FunctionCall>(@$,$1,$2); }
 
-operation: expression '+' expression     {$$ = new Operation($1,$3,op_sum); }
-         | expression '-' expression     {$$ = new Operation($1,$3,op_sub); }
-         | expression '*' expression     {$$ = new Operation($1,$3,op_mul); }
-         | expression '/' expression     {$$ = new Operation($1,$3,op_div); }
-         | expression '^' expression     {$$ = new Operation($1,$3,op_exp); }
-         | expression '[' expression ']' {$$ = new Operation($1,$3,op_ref); }
+operation: expression '+' expression     {$$ = lex.make<Operation>(@$,$1,$3,op_sum); }
+         | expression '-' expression     {$$ = lex.make<Operation>(@$,$1,$3,op_sub); }
+         | expression '*' expression     {$$ = lex.make<Operation>(@$,$1,$3,op_mul); }
+         | expression '/' expression     {$$ = lex.make<Operation>(@$,$1,$3,op_div); }
+         | expression '^' expression     {$$ = lex.make<Operation>(@$,$1,$3,op_exp); }
+         | expression '[' expression ']' {$$ = lex.make<Operation>(@$,$1,$3,op_ref); }
 
-vector-item: expression {$$ = new Vector(); $$->add_expression($1); }
-           | vector-item ',' expression {$$ = $1; $$->add_expression($3); }
+vector-item: expression {$$ = lex.make<Vector>(@$); $$->add_expression($1); }
+           | vector-item ',' expression {$$ = lex.locate($1,@$); $$->add_expression($3); }
 
-vector: '(' vector-item ')' {$$ = $2;}
-      | '(' ')' {$$ = new Vector();}
+vector: '(' vector-item ')' {$$ = lex.locate($2,@$);}
+      | '(' ')' {$$ = lex.make<Vector>(@$);}
 
 %%
 
+//The pattern already checked the syntax, the number is read in place
+static double parse_number(const char* begin,const char* end)
+{
+    double value = 0;
+    std::from_chars(begin,end,value);
+    return value;
+}
+
 yy::conj_parser::symbol_type yy::yylex(lexcontext &ctx)
 {
-    const char* anchor = ctx.cursor;
-    ctx.loc.step();
-    auto s = [&](auto func, auto&&... params) { ctx.loc.columns(ctx.cursor - anchor); return func(params..., ctx.loc); };
+    //Whitespace and comments go around the loop, everything else returns a token
+    for (;;)
+    {
+        const char* anchor = ctx.cursor;
+        ctx.loc.step();
+        auto s = [&](auto func, auto&&... params) { ctx.loc.columns(ctx.cursor - anchor); return func(params..., ctx.loc); };
 
         %{ /* Begin re2c lexer */
         re2c:yyfill:enable   = 0;
@@ -129,18 +162,18 @@ yy::conj_parser::symbol_type yy::yylex(lexcontext &ctx)
         "if"                    { return s(conj_parser::make_IF); } */
         
         // Identifiers:
-        [a-zA-Z_] [a-zA-Z_0-9]* { return s(conj_parser::make_IDENTIFIER, std::string(anchor,ctx.cursor)); }
+        [a-zA-Z_] [a-zA-Z_0-9]* { return s(conj_parser::make_IDENTIFIER, std::string_view(anchor,ctx.cursor - anchor)); }
         
         // String and integer literals:
-        "\"" [^"]* "\""         { return s(conj_parser::make_STRINGCONST, std::string(anchor+1, ctx.cursor-1)); }
-        [0-9]+                  { return s(conj_parser::make_NUMCONST, std::stol(std::string(anchor,ctx.cursor))); } 
-        [0-9]*"."[0-9]+         { return s(conj_parser::make_NUMCONST, std::stod(std::string(anchor,ctx.cursor))); } 
-        [0-9]+"."[0-9]*         { return s(conj_parser::make_NUMCONST, std::stod(std::string(anchor,ctx.cursor))); } 
+        "\"" [^"]* "\""         { return s(conj_parser::make_STRINGCONST, std::string_view(anchor + 1,ctx.cursor - anchor - 2)); }
+        [0-9]+                  { return s(conj_parser::make_NUMCONST, parse_number(anchor,ctx.cursor)); } 
+        [0-9]*"."[0-9]+         { return s(conj_parser::make_NUMCONST, parse_number(anchor,ctx.cursor)); } 
+        [0-9]+"."[0-9]*         { return s(conj_parser::make_NUMCONST, parse_number(anchor,ctx.cursor)); } 
         // Whitespace and comments:
         "\000"                  { return s(conj_parser::make_END); }
-        "\r\n" | [\r\n]         { ctx.loc.lines();   return yylex(ctx); }
-        "//" [^\r\n]*           {                    return yylex(ctx); }
-        [\t\v\b\f ]             { ctx.loc.columns(); return yylex(ctx); }
+        "\r\n" | [\r\n]         { ctx.loc.lines();   continue; }
+        "//" [^\r\n]*           {                    continue; }
+        [\t\v\b\f ]+            { ctx.loc.columns(ctx.cursor - anchor); continue; }
         
         // Multi-char operators and any other character (either an operator or an invalid symbol):
         /*
@@ -154,6 +187,7 @@ yy::conj_parser::symbol_type yy::yylex(lexcontext &ctx)
         "-="                    { return s(conj_parser::make_MI_EQ); } */
         .                       { return s([](auto...s){return conj_parser::symbol_type(s...);}, conj_parser::token_type(ctx.cursor[-1]&0xFF)); } // Return that character 
         %} /* End lexer */
+    }
 }
 
 void yy::conj_parser::error(const location_type& l, const std::string& m)
@@ -162,23 +196,70 @@ void yy::conj_parser::error(const location_type& l, const std::string& m)
     std::cerr << ':' << l.begin.line << ':' << l.begin.column << '-' << l.end.column << ": " << m << '\n';
 }
 
-//Initialize scope so it can be reused
-int parse_to_latex(const string& code, string& result)
+//Parses NUL terminated code, nullptr on a syntax error
+static Expression* parse_text(const char* code,const string& filename,Scope& scope)
 {
-    const string filename = "<input>";
-
     lexcontext ctx;
-    ctx.cursor = code.c_str();
+    ctx.cursor = code;
     ctx.loc.begin.filename = &filename;
     ctx.loc.end.filename   = &filename;
-
-    Scope scope;
-    Scope::initialize_scope(&scope);
-    registerInternalFunctions();
+    ctx.scope = &scope;
 
     yy::conj_parser parser(ctx);
     parser.parse();
+    return ctx.root;
+}
+
+Expression* parse_tree(const string& code, Scope& scope)
+{
+    const string filename = "<input>";
+    return parse_text(code.c_str(),filename,scope);
+}
+
+//Parses code into scope, which becomes the current scope
+void parse_document(const string& code, Scope& scope)
+{
+    Expression* root = parse_tree(code,scope);
+    if (root) scope.set_root_expression(root);
+}
+
+void parse_file(const string& path, Scope& scope)
+{
+    MappedFile source(path);
+    scope.sourceName = path;
+    uint64_t hash = 0;
+    string cache;
+    if (!scope.cacheDirectory.empty())
+    {
+        hash = content_hash(source.data(),source.size());
+        cache = ast_cache_path(scope.cacheDirectory,hash);
+        if (Expression* root = load_ast(cache,hash,source.size(),scope))
+        {
+            scope.set_root_expression(root);
+            return;
+        }
+    }
+
+    Expression* root = parse_text(source.data(),path,scope);
+    if (root == nullptr) return;
+    //Stored before name resolution and optimization change the tree
+    if (!cache.empty()) store_ast(cache,hash,source.size(),root);
+    scope.set_root_expression(root);
+}
+
+//Initialize scope so it can be reused
+int parse_to_latex(const string& code, string& result)
+{
+    OutputSink out(result);
+    return parse_to_latex(code,out);
+}
+
+int parse_to_latex(const string& code, OutputSink& out)
+{
+    Scope scope;
+    parse_document(code,scope);
     
-    scope.rootExpression->print(result);
+    render_document(scope,out);
+    out.flush();
     return 0;
 }
@@ -1,25 +1,114 @@
-#include <fstream>
-int main(int argc, char** argv)
+#include <cstring>
+#include "server.h"
+#include "profile.h"
+#include <fcntl.h>
+//Usage: expr [--tree | --vm | --check | --profile] file
+//       expr --serve [socket]
+//Without options the document is translated to latex, otherwise it is evaluated
+//with the tree walker, the bytecode vm or both and the results compared.
+//--profile evaluates with the tree walker, prints the time and memory per node and function to stderr
+//and writes the stacks for flamegraph.pl to file.folded
+//--serve answers framed documents from stdin, or from the connections to a Unix socket, see server.h
+//EXPRESS_MEMO=<entries> memoizes pure functions in the tree walker and reports the cache use
+//EXPRESS_THREADS=<threads> sets the threads the tree walker evaluates independent work with
+//EXPRESS_CACHE=<directory> keeps the parsed documents there, unchanged files are not parsed again
+//EXPRESS_NATIVE=<directory> compiles pure numeric functions with g++ and keeps the objects there
+static int run(int argc, char** argv)
 {
-    std::string filename = argv[1];
-    std::ifstream f(filename);
-    std::string buffer(std::istreambuf_iterator<char>(f), {});
+    if (std::string(argv[1]) == "--serve")
+    {
+        if (argc > 2) return serve_socket(argv[2]);
+        serve(STDIN_FILENO,STDOUT_FILENO);
+        return 0;
+    }
 
-    lexcontext ctx;
-    ctx.cursor = buffer.c_str();
-    ctx.loc.begin.filename = &filename;
-    ctx.loc.end.filename   = &filename;
+    std::string option = argc > 2 ? argv[1] : "";
+    std::string filename = argv[argc - 1];
 
     Scope scope;
-    Scope::initialize_scope(&scope);
-    registerInternalFunctions();
-
-    yy::conj_parser parser(ctx);
-    parser.parse();
+    parse_file(filename,scope);
+    //The parser reported where the syntax is wrong
+    if (scope.rootExpression == nullptr)
+    {
+        cerr << filename << ": not parsed, nothing is evaluated" << endl;
+        return 1;
+    }
+    #ifdef DEBUG
     string prefix;
     debug_print_expression(scope.rootExpression,prefix);
-    //cout << scope.evaluate() << endl;
-    string result;
-    scope.rootExpression->print(result);
-    cout << result << endl;
+    #endif
+
+    if (option == "--tree" || option == "--vm")
+    {
+        scope.mode = option == "--vm" ? eval_bytecode : eval_tree;
+        cout << scope.evaluate() << endl;
+        for (Function* function : scope.pureFunctions)
+        {
+            if (function->cache == nullptr) continue;
+            cerr << "memo " << (function->symbol >= 0 ? scope.symbols.name(function->symbol) : "<anonymous>");
+            cerr << ": " << function->cache->hits << " hits, " << function->cache->misses << " misses" << endl;
+        }
+        return 0;
+    }
+    if (option == "--profile")
+    {
+        Profiler* profiler = start_profile(scope);
+        Value result = scope.evaluate();
+        finish_profile(scope,profiler);
+        cout << result << endl;
+        {
+            OutputSink report(STDERR_FILENO);
+            write_profile(profiler,report);
+        }
+        std::string folded = filename + ".folded";
+        int fd = ::open(folded.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+        if (fd < 0)
+        {
+            cerr << "Cannot write " << folded << endl;
+            release_profiler(profiler);
+            return 1;
+        }
+        {
+            OutputSink stacks(fd);
+            write_folded_stacks(profiler,stacks);
+        }
+        ::close(fd);
+        release_profiler(profiler);
+        return 0;
+    }
+    if (option == "--check")
+    {
+        Value tree = scope.evaluate();
+        scope.mode = eval_bytecode;
+        Value vm = scope.evaluate();
+        cout << tree << endl << vm << endl;
+        if (tree != vm)
+        {
+            cerr << "Bytecode result differs from the tree walker" << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    OutputSink out(STDOUT_FILENO);
+    render_document(scope,out);
+    out += '\n';
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: expr [--tree | --vm | --check | --profile] file" << endl;
+        cerr << "       expr --serve [socket]" << endl;
+        return 1;
+    }
+    //Files that can not be read, sockets that can not be served and documents the vm does not compile
+    try { return run(argc,argv); }
+    catch (const std::runtime_error& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
 }
@@ -0,0 +1,55 @@
+#include "express.h"
+#include "incremental.h"
+
+ExpressProgram::ExpressProgram() : scope(new Scope()) { }
+
+ExpressProgram::~ExpressProgram()
+{
+    delete document;
+    delete scope;
+}
+
+std::unique_ptr<ExpressProgram> ExpressProgram::compile(const std::string& code)
+{
+    std::unique_ptr<ExpressProgram> program(new ExpressProgram());
+    parse_document(code,*program->scope);
+    program->prepare();
+    return program;
+}
+
+std::unique_ptr<ExpressProgram> ExpressProgram::compile_file(const std::string& path)
+{
+    std::unique_ptr<ExpressProgram> program(new ExpressProgram());
+    parse_file(path,*program->scope);
+    program->prepare();
+    return program;
+}
+
+void ExpressProgram::prepare()
+{
+    if (scope->rootExpression == nullptr) throw std::runtime_error("Express: the document could not be parsed");
+    document = new IncrementalDocument(*scope);
+}
+
+void ExpressProgram::bind(const std::string& name,double value)
+{
+    document->rebind(name,Value(value));
+}
+
+void ExpressProgram::bind(const std::string& name,const std::vector<double>& value)
+{
+    document->rebind(name,Value(value));
+}
+
+std::vector<double> ExpressProgram::evaluate()
+{
+    FrameSwitch frame(*scope,scope->global);
+    Value result = scope->evaluate();
+    if (result.is_string()) throw std::runtime_error("Express: the document evaluates to a string");
+    return std::vector<double>(result.begin(),result.end());
+}
+
+std::string ExpressProgram::render_latex()
+{
+    return document->render();
+}
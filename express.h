@@ -1,3 +1,47 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <memory>
+struct Scope;
+struct Expression;
+struct IncrementalDocument;
+struct OutputSink;
 int parse_to_latex(const std::string& code,std::string& result);
+//Streams the latex into a string, a file descriptor or a callback, see output_sink.h
+int parse_to_latex(const std::string& code,OutputSink& out);
+//Keeps the document alive in scope, see incremental.h to render it and batch.h to evaluate it over many inputs
+void parse_document(const std::string& code,Scope& scope);
+//Only parses, nullptr on a syntax error. Scope::set_root_expression makes the tree the document
+Expression* parse_tree(const std::string& code,Scope& scope);
+//Same as parse_document for a file, which is mapped instead of read and may come from the cache of parsed documents, see ast_cache.h
+void parse_file(const std::string& path,Scope& scope);
+
+/*
+    Compiled document for embedding. Parsing, name resolution and optimization happen
+    once in compile(), then the document can be rebound, evaluated and rendered as many
+    times as needed. A render only redoes the statements that read a rebound name.
+*/
+struct ExpressProgram
+{
+    static std::unique_ptr<ExpressProgram> compile(const std::string& code);
+    static std::unique_ptr<ExpressProgram> compile_file(const std::string& path);
+
+    ExpressProgram(const ExpressProgram&) = delete;
+    ExpressProgram& operator=(const ExpressProgram&) = delete;
+    ~ExpressProgram();
+
+    //Replaces the value of a top level assignment
+    void bind(const std::string& name,double value);
+    void bind(const std::string& name,const std::vector<double>& value);
+
+    std::vector<double> evaluate();
+    std::string render_latex();
+
+    private:
+
+    ExpressProgram();
+    void prepare();
+
+    Scope* scope;
+    IncrementalDocument* document = nullptr;
+};
@@ -2,6 +2,8 @@
 #include "global.h"
 #include "value.h"
 #include "scope.h"
+#include "output_sink.h"
+#include "render.h"
 #include <map>
 #include <stack>
 #include <list>
@@ -30,6 +32,13 @@ static const char* ExpressionType_literals[] = { ExpressionType_d(o) };
 
 #define literalType(e) ExpressionType_literals[e->getType()]
 
+//Lines and columns of the text a node was parsed from, line 0 when it was not parsed
+struct SourceSpan
+{
+    unsigned line = 0, column = 0;
+    unsigned endLine = 0, endColumn = 0;
+};
+
 struct Expression
 {
     Expression() { }
@@ -38,19 +47,38 @@ struct Expression
     void setType(ExpressionType _type) {  type = _type;  }
     ExpressionType getType() const {return type; }
 
-    virtual Value i_evaluate() = 0;
+    virtual Value i_evaluate(Scope& scope) = 0;
 
     Value lastEvaluatedValue;
     bool wasEvaluated = false;
 
-    Value evaluate()
+    //Set by the optimizer, see optimizer.h
+    bool is_folded = false;
+    int common = -1;
+    const Layout* commonLayout = nullptr;
+
+    bool pinned = false;                //Keeps its value while a render evaluates the statement, see render.h
+
+    SourceSpan span;
+
+    Value evaluate(Scope& scope)
+    {
+        if ((is_folded || pinned) && wasEvaluated) return lastEvaluatedValue;
+        if (scope.profiler) return profiled_evaluate(scope);
+        return evaluate_node(scope);
+    }
+    Value evaluate_node(Scope& scope)
     {
+        if (common >= 0) return evaluate_common(scope);
         wasEvaluated = true;
-        return lastEvaluatedValue = i_evaluate();
+        return lastEvaluatedValue = i_evaluate(scope);
     }
+    Value evaluate_common(Scope& scope);
+    Value profiled_evaluate(Scope& scope);     //See profile.h
+    //Both properties are kept up to date by dependency(), nodes are built bottom up
     bool is_final() const 
     {
-        for(Expression* expr: dependencies) if (!expr->is_final()) return false;
+        if (!finalDependencies) return false;
 
         switch  (type)
         {
@@ -64,7 +92,7 @@ struct Expression
 
     bool is_const() const
     {
-        for(Expression* expr: dependencies) if (!expr->is_const()) return false;
+        if (!constDependencies) return false;
 
         switch (type)
         {
@@ -73,24 +101,25 @@ struct Expression
             default: return false;
         }
     }
-    virtual void i_print(std::string& str) = 0;
+    virtual void i_print(const RenderView& view,OutputSink& str) = 0;
 
-    void print(std::string& str)
+    void print(const RenderView& view,OutputSink& str)
     {
-        if (wasEvaluated) str += lastEvaluatedValue;
-        else i_print(str);
+        if (const Value* value = view.value(this)) str += *value;
+        else i_print(view,str);
     }
-    private:
-    ExpressionType type;
+    std::vector<Expression*> dependencies;
 
+    protected:
+    void dependency(Expression* expression)
+    {
+        dependencies.push_back(expression);
+        finalDependencies &= expression->is_final();
+        constDependencies &= expression->is_const();
+    }
 
-    #ifdef DEBUG
-    public:
-    list<Expression*> dependencies;
-    #endif
-
+    private:
+    ExpressionType type;
+    bool finalDependencies = true;      //Every dependency is final
+    bool constDependencies = true;      //Every dependency is constant
 };
-
-#ifdef DEBUG
-#define dependency(x) dependencies.push_back(x)
-#endif
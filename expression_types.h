@@ -2,7 +2,12 @@
 #include "global.h"
 #include "expression.h"
 #include "expression_util.h"
-#include <sstream>
+#include "fusion.h"
+#include "parallel.h"
+#include "function_cache.h"
+#include "math_kernels.h"
+#include "native.h"
+#include <cctype>
 struct Constant : public Expression
 {
     Value v;
@@ -13,67 +18,117 @@ struct Constant : public Expression
         v = _v;
     }
 
-    virtual Value i_evaluate() override { return v; }
-    virtual void i_print(std::string &str)
+    virtual Value i_evaluate(Scope& scope) override { return v; }
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
         str += v;
     }
 };
 
+struct Variable : public Expression
+{
+    int symbol;
+    const string& name;                 //Interned with the symbol
+    bool represents_vector;
+
+    int depth = -1;                     //Resolved position, see resolver.h
+    int slot = -1;
+    const Layout* layout = nullptr;
+
+    Variable(Symbols& symbols,std::string_view _name) : symbol(symbols.intern(_name)), name(symbols.name(symbol))
+    { 
+        setType(ex_Variable);
+        represents_vector = false;
+    }
+
+    Binding* binding(Scope& scope) { return scope.lookup(this); }
+    Expression* get(Scope& scope) { return binding(scope)->expression; }
+    virtual Value i_evaluate(Scope& scope) override { return force(scope,binding(scope)); }
+
+    //Evaluates a thunk, the value is reused until something is assigned
+    static Value force(Scope& scope,Binding* binding)
+    {
+        if (binding->epoch == scope.epoch) return binding->value;
+
+        unsigned epoch = scope.epoch;
+        Value v;
+        //Builtins are shared by every scope and are never written to
+        if (binding->frame == nullptr) v = binding->expression->i_evaluate(scope);
+        else
+        {
+            FrameSwitch frame(scope,binding->frame);
+            v = binding->expression->evaluate(scope);
+        }
+        if (scope.epoch == epoch)
+        {
+            binding->value = v;
+            binding->epoch = epoch;
+        }
+        return v;
+    }
+
+    virtual void i_print(const RenderView& view,OutputSink& str)
+    {
+        if (represents_vector) str += "\\vec{";
+        str += name;
+        if (represents_vector) str += "}";
+    }
+};
 struct StringConstant : public Expression
 {
+    //Literal text and the name interpolated right after it, the last one has none
+    struct Segment
+    {
+        std::string text;
+        Variable* variable;
+    };
+
     Value str;
     Value finalStr;
+    std::vector<Segment> segments;      //Parsed once, the names are bound by the resolver
 
-    StringConstant(const Value& _str)
+    StringConstant(Scope& scope,const Value& _str)
     {
         setType(ex_StringConstant);
         str = _str;
+
+        //$name interpolates the name, everything else is kept as written
+        std::string text = str.as_string();
+        size_t begin = 0;
+        for (size_t i = text.find('$'); i != std::string::npos; i = text.find('$',i + 1))
+        {
+            size_t end = i + 1;
+            while (end < text.size() && (isalnum((unsigned char)text[end]) || text[end] == '_')) end++;
+            if (end == i + 1 || isdigit((unsigned char)text[i + 1])) continue;
+            segments.push_back({text.substr(begin,i - begin),scope.arena.make<Variable>(scope.symbols,std::string_view(text).substr(i + 1,end - i - 1))});
+            begin = end;
+            i = end - 1;
+        }
+        segments.push_back({text.substr(begin),nullptr});
     }
 
-    const std::string evalString()
+    //Formats the value of every name, as the bytecode vm does
+    void interpolate(Scope& scope,OutputSink& out)
     {
-        std::stringstream ss(str);
-        std::string token;
-        std::string result = "";
-        while (ss >> token)
+        for (const Segment& segment : segments)
         {
-            if (token[0] == '$')
-            {
-                token.erase(0,1);
-                Scope::scope->resolve(token)->print(result);
-            }
-            else
-            result += token + " ";
+            out += segment.text;
+            if (segment.variable) out += Variable::force(scope,segment.variable->binding(scope));
         }
-        return result;
     }
-    virtual Value i_evaluate() override { finalStr.str = evalString(); return finalStr; }
-    virtual void i_print(std::string &str)
+    virtual Value i_evaluate(Scope& scope) override
     {
-        str += finalStr;
-    }
-};
-struct Variable : public Expression
-{
-    string name;
-    bool represents_vector;
-
-    Variable(const string& _name)
-    { 
-        setType(ex_Variable);
-        name = _name; 
-        represents_vector = false;
+        std::string result;
+        {
+            OutputSink out(result);
+            interpolate(scope,out);
+        }
+        return finalStr = Value(result);
     }
-
-    Expression* get() { return Scope::scope->resolve(name); }
-    virtual Value i_evaluate() override { return get()->evaluate(); } 
-
-    virtual void i_print(std::string& str)
+    //Until it is evaluated a string shows as it was written
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
-        if (represents_vector) str += "\\vec{";
-        str += name;
-        if (represents_vector) str += "}";
+        str += this->str;
     }
 };
 struct Assignment : public Expression 
@@ -91,31 +146,30 @@ struct Assignment : public Expression
         if (assignment->getType() == ex_Vector) identifier->represents_vector = true;
     }
 
-    virtual Value i_evaluate() override { 
-        Expression* expr = Scope::scope->define(identifier->name,assignment); 
-        return expr->evaluate();
-    }
+    virtual Value i_evaluate(Scope& scope) override { return Variable::force(scope,bind(scope)); }
 
-    virtual void i_print(std::string& str)
+    //Binds the name without evaluating it, the value is computed when first referenced
+    Binding* bind(Scope& scope) { return scope.assign(identifier,assignment); }
+
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
         if (assignment->is_final())
         {
-            identifier->print(str);
+            identifier->print(view,str);
             str += " = ";
-            latexize(assignment,str);
+            latexize(view,assignment,str);
         }
         else if (assignment->getType() != ex_Function)
         {
-            identifier->print(str);
+            identifier->print(view,str);
             str += " = ";
-            assignment->print(str);
+            assignment->print(view,str);
         }
         else
         {
-            identifier->print(str);
-            assignment->print(str);
+            identifier->print(view,str);
+            assignment->print(view,str);
         }
-        evaluate();
     }
 };
 
@@ -125,19 +179,28 @@ struct Vector : public Expression
 
     Vector() { setType(ex_Vector);  }
 
-    virtual Value i_evaluate() override
+    virtual Value i_evaluate(Scope& scope) override
     {
         if (variables.size() != 1)
         {
-            Value values = variables[0]->evaluate()[0];
+            Value values;
+            if (parallel_evaluate(scope,this,values)) return values;
+            values = variables[0]->evaluate(scope)[0];
             for (size_t i = 1; i < variables.size(); i++)
             {
-                values.push_back(variables[i]->evaluate()[0]);
+                values.push_back(variables[i]->evaluate(scope)[0]);
             }
             return values;
         }
 
-        return variables[0]->evaluate();
+        return variables[0]->evaluate(scope);
+    }
+
+    //Evaluates only the element that is indexed
+    Value element(Scope& scope,size_t index)
+    {
+        if (variables.size() == 1 || index >= variables.size()) return evaluate(scope)[index];
+        return variables[index]->evaluate(scope)[0];
     }
 
     inline Expression* at(size_t index) { return variables[index]; }
@@ -150,19 +213,19 @@ struct Vector : public Expression
         dependency(expression);
     }
 
-    void print_content(std::string& str)
+    void print_content(const RenderView& view,OutputSink& str)
     {
         for (size_t i = 0 ; i < variables.size(); i++)
         {
-            variables[i]->print(str);
+            variables[i]->print(view,str);
             if (i != variables.size() - 1) str += ",";
         }
 
     }
-    virtual void i_print(std::string &str)
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
         str += "(";
-        print_content(str);
+        print_content(view,str);
         str += ")";
     }
 
@@ -186,21 +249,25 @@ static const char* OperationTypeLiterals[] = { OPERATION_TYPE_ENUM(o) };
 
 #define operationLiteral(e) ( OperationTypeLiterals[(static_cast<Operation*>(e))->op_type] )
 
+struct FusedPlan;
 struct Operation : public Expression
 {
     Expression *a,*b;
     OperationType op_type;
+    FusedPlan* plan = nullptr;          //Built on first fused evaluation
     Operation(Expression *_a,Expression *_b,OperationType _op_type) : a(_a), b(_b),op_type(_op_type) 
     {
         setType(ex_Operation);
         dependency(a);
         dependency(b);
     }
+    ~Operation() { release_fused_plan(plan); }
 
-    virtual Value i_evaluate() override 
+    virtual Value i_evaluate(Scope& scope) override 
     { 
+        if (is_fusable(this)) return fused_evaluate(scope,this);
 
-        #define case_operation(type,operatort) case type: return a->evaluate() operatort b->evaluate();
+        #define case_operation(type,operatort) case type: return a->evaluate(scope) operatort b->evaluate(scope);
         switch(op_type)
         {
             case_operation(op_sum,+);
@@ -209,17 +276,33 @@ struct Operation : public Expression
             case_operation(op_div,/);
             case_operation(op_exp,^);
             case op_ref:
-                return a->evaluate()[b->evaluate()[0]];
+                return reference(scope,a,b->evaluate(scope)[0]);
         }
         #undef case_operation
 
         throw new std::runtime_error("Invalid operation type");
     }
 
-    virtual void i_print(std::string& str)
+    //Indexing a vector literal, directly or through a name that was not forced yet, only evaluates one element
+    static Value reference(Scope& scope,Expression* expression,size_t index)
+    {
+        if (expression->getType() == ex_Vector) return static_cast<Vector*>(expression)->element(scope,index);
+        if (expression->getType() == ex_Variable)
+        {
+            Binding* binding = static_cast<Variable*>(expression)->binding(scope);
+            if (binding->epoch != scope.epoch && binding->expression->getType() == ex_Vector)
+            {
+                FrameSwitch frame(scope,binding->frame);
+                return static_cast<Vector*>(binding->expression)->element(scope,index);
+            }
+        }
+        return expression->evaluate(scope)[index];
+    }
+
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
         if (op_type == op_div) str += "\\frac{";
-        a->print(str);
+        a->print(view,str);
         if (op_type == op_div) str += "}";
         switch(op_type)
         {
@@ -231,7 +314,7 @@ struct Operation : public Expression
         }
         
         if (op_type == op_div || op_type == op_exp) str += "{";
-        b->print(str);
+        b->print(view,str);
         if (op_type == op_div || op_type == op_exp) str += "}";
 
         if (op_type == op_ref) str += "]";
@@ -247,11 +330,11 @@ struct ReturnExpression : public Expression
         dependency(returnValue);
     }
 
-    virtual Value i_evaluate() override { return returnValue->evaluate(); }
-    virtual void i_print(std::string & str)
+    virtual Value i_evaluate(Scope& scope) override { return returnValue->evaluate(scope); }
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
         str += "return ";
-        returnValue->print(str);
+        returnValue->print(view,str);
     }
 };
 
@@ -259,40 +342,65 @@ struct ExpressionBlock : public Expression
 {
     vector<Expression*> expressions;
     Vector *parameterVector, *valueVector;
+    Frame* environment = nullptr;
     bool expectsParameters = false;
+    bool is_global = false;             //The document block lives in Scope::global
+
+    Layout layout;
 
     ExpressionBlock() { setType(ex_ExpressionBlock); }
 
-    void set_variable_vectors(Vector* _parameterVector,Vector* _valueVector)
+    void set_variable_vectors(Vector* _parameterVector,Vector* _valueVector,Frame* _environment)
     {
         parameterVector = _parameterVector;
         valueVector = _valueVector;
+        environment = _environment;
     }
-    void initialize_body()
+    //Checked before the frame of the body is entered, release builds have no asserts
+    void check_arguments()
+    {
+        if (parameterVector && valueVector && parameterVector->size() == valueVector->size()) return;
+        size_t expected = parameterVector ? parameterVector->size() : 0, given = valueVector ? valueVector->size() : 0;
+        parameterVector = nullptr;
+        valueVector = nullptr;
+        environment = nullptr;
+        throw std::runtime_error("Wrong number of arguments for a function call: " + std::to_string(given) + " given, " + std::to_string(expected) + " expected");
+    }
+    //Arguments are bound to the caller frame, they are evaluated where they were written
+    void initialize_body(Scope& scope,Frame* caller)
     {
-        assert(parameterVector);
-        assert(valueVector);
-        assert(parameterVector->size() == valueVector->size());
         int m = parameterVector->size();
         for(int i = 0; i < m; i++)
         {
-            Scope::scope->define(static_cast<Variable*>(parameterVector->at(i))->name,valueVector->at(i));
+            Binding& binding = scope.current->slots[static_cast<Variable*>(parameterVector->at(i))->slot];
+            binding.expression = valueVector->at(i);
+            binding.frame = caller;
         }
     }
-    virtual Value i_evaluate() override
+    virtual Value i_evaluate(Scope& scope) override
     {
-        ++(*Scope::scope);      //Increase and decrease scope
-        if (expectsParameters) initialize_body();
+        if (expectsParameters) check_arguments();
+        Frame* previous = scope.current;
+        if (!is_global) scope.enter(&layout,expectsParameters && environment ? environment : previous);
+        if (expectsParameters) initialize_body(scope,previous);
         Value v;
         for(int i = 0; i < expressions.size(); i++)
         {
             Expression* current = expressions[i];
-            v = current->evaluate();
-            if (getType() == ex_ReturnExpression) break;
+            //Only the value of the last statement is needed, assignments before it stay thunks
+            if (current->getType() == ex_Assignment && i + 1 < expressions.size())
+            {
+                static_cast<Assignment*>(current)->bind(scope);
+                continue;
+            }
+            if (current->getType() != ex_Assignment) parallel_force(scope,current);
+            v = current->evaluate(scope);
+            if (current->getType() == ex_ReturnExpression) break;
         }
-        --(*Scope::scope);
+        if (!is_global) scope.leave(previous);
         parameterVector = nullptr;
         valueVector = nullptr;
+        environment = nullptr;
         return v;
     }
 
@@ -302,11 +410,11 @@ struct ExpressionBlock : public Expression
         dependency(expression);
     }
 
-    virtual void i_print(std::string & str)
+    virtual void i_print(const RenderView& view,OutputSink& str)
     {
         for(Expression* expression : expressions)
         {
-            expression->print(str);
+            expression->print(view,str);
             if (expression != expressions.back()) str += "\n";
         }
     }
@@ -318,6 +426,18 @@ struct Function : public Expression
     ExpressionBlock* expressionBlock;
     
     bool is_internal = false;
+    bool is_pure = false;               //Result depends only on the argument values, see resolver.cc
+    int symbol = -1;                    //Name the function is assigned to, if any
+    FunctionCache* cache = nullptr;     //Created on the first memoized call
+    //Arguments of a call in progress that were evaluated before the body ran
+    struct BoundArguments
+    {
+        Vector* arguments;
+        std::vector<Constant*> constants;
+    };
+    std::vector<BoundArguments> bound;  //One per call in progress, reused
+    size_t boundDepth = 0;
+    NativeFunction* native = nullptr;   //Compiled body, see native.h
 
     Function()
     {
@@ -331,20 +451,67 @@ struct Function : public Expression
         dependency(expressionBlock);
         expressionBlock->expectsParameters = true;
     }
+    ~Function() { delete cache; }
 
-    virtual Value i_evaluate() override { return 0; }
+    virtual Value i_evaluate(Scope& scope) override { return Value::empty_vector(); }
 
-    virtual Value evaluate(Vector* valueVector)
+    virtual Value evaluate(Scope& scope,Vector* valueVector,Frame* environment)
     {
-        expressionBlock->set_variable_vectors(parameterVector,valueVector);
-        return expressionBlock->evaluate();
+        expressionBlock->set_variable_vectors(parameterVector,valueVector,environment);
+        return expressionBlock->evaluate(scope);
     }
 
-    virtual void i_print(std::string & str)
+    //The parameters read the values already evaluated, the other arguments stay as written and are evaluated on use
+    Value evaluate_bound(Scope& scope,Vector* valueVector,const std::vector<Value>& values,const std::vector<bool>& evaluated,Frame* environment)
     {
-        parameterVector->print(str);
+        if (valueVector->size() != parameterVector->size()) return evaluate(scope,valueVector,environment);
+        if (boundDepth == bound.size())
+        {
+            BoundArguments call{scope.arena.make<Vector>()};
+            for (size_t i = 0; i < parameterVector->size(); i++)
+            {
+                call.constants.push_back(scope.arena.make<Constant>(Value()));
+                call.arguments->add_expression(call.constants.back());
+            }
+            bound.push_back(call);
+        }
+        BoundArguments& call = bound[boundDepth++];
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            if (evaluated[i]) call.constants[i]->v = values[i];
+            call.arguments->variables[i] = evaluated[i] ? call.constants[i] : valueVector->at(i);
+        }
+        Vector* arguments = call.arguments;
+        Value result;
+        try { result = evaluate(scope,arguments,environment); }
+        catch (...) { boundDepth--; throw; }
+        boundDepth--;
+        return result;
+    }
+
+    //Arguments are evaluated up front to build the key, the body only runs on a miss.
+    //The values a native call already evaluated, marked in evaluated, are part of the key as they are
+    Value memoized_evaluate(Scope& scope,Vector* valueVector,Frame* environment,size_t capacity,std::vector<Value>& key,std::vector<bool>& evaluated)
+    {
+        if (cache == nullptr) cache = new FunctionCache(capacity);
+        key.resize(valueVector->size());
+        evaluated.resize(valueVector->size());
+        for (size_t i = 0; i < key.size(); i++)
+        {
+            if (!evaluated[i]) key[i] = valueVector->at(i)->evaluate(scope);
+            evaluated[i] = true;
+        }
+        if (const Value* hit = cache->find(key)) return *hit;
+        Value result = evaluate_bound(scope,valueVector,key,evaluated,environment);
+        cache->insert(key,result);
+        return result;
+    }
+
+    virtual void i_print(const RenderView& view,OutputSink& str)
+    {
+        parameterVector->print(view,str);
         str += " = ";
-        expressionBlock->print(str);
+        expressionBlock->print(view,str);
     }
 };
 
@@ -356,12 +523,14 @@ enum internalfunctionType
 struct internalFunctionPtr
 {
     using scalarFunctionPtr = double (*) (double);
-    using vectorFunctionPtr = double (*) (Value);
+    using vectorFunctionPtr = double (*) (const Value&);
     using expresionFunctionPtr = Expression* (*) (Vector*);
+    using batchFunctionPtr = MathKernels::mapKernel;
 
     scalarFunctionPtr scalarFunction;
     vectorFunctionPtr vectorFunction;
     expresionFunctionPtr expresionFunction;
+    batchFunctionPtr batchFunction = nullptr;   //Scalar function applied to a whole vector at once, see math_kernels.h
     
     internalfunctionType type;
 
@@ -373,10 +542,15 @@ struct internalFunctionPtr
     {
         return scalarFunction(args);
     }
-    double get_vector(Value args)
+    double get_vector(const Value& args)
     {
         return vectorFunction(args);
     }
+    void get_batch(double* out,const double* args,size_t n)
+    {
+        if (batchFunction) { batchFunction(out,args,n); return; }
+        for (size_t i = 0; i < n; i++) out[i] = scalarFunction(args[i]);
+    }
 
     Expression* get_expr(Vector* args) { return expresionFunction(args); }
 };
@@ -398,27 +572,40 @@ struct InternalFunction : public Function
         setType(ex_InternalFunction);
         is_internal = true;
     }
-    virtual Value i_evaluate() override 
+    virtual Value i_evaluate(Scope& scope) override 
     {
-        return 0;
+        return Value::empty_vector();
     }
 
-    virtual Value evaluate(Vector* valueVector) override
+    virtual Value evaluate(Scope& scope,Vector* valueVector,Frame* environment) override
     {
         Value oldvalue;
-        if (functionPtr.type != fn_expression) oldvalue = valueVector->at(0)->evaluate();
-        Value result = oldvalue;
-    
+        if (functionPtr.type == fn_expression) return apply(oldvalue);
+
+        Expression* argument = valueVector->at(0);
+        if (functionPtr.type == fn_vector && argument->getType() == ex_Operation)
+        {
+            //Reductions over element wise operations never build the reduced vector
+            if (functionPtr.vectorFunction == vsum) return fused_reduce(scope,static_cast<Operation*>(argument),reduce_sum);
+            if (functionPtr.vectorFunction == vprod) return fused_reduce(scope,static_cast<Operation*>(argument),reduce_prod);
+        }
+        oldvalue = argument->evaluate(scope);
+        return apply(oldvalue);
+    }
+
+    //Applies a scalar or vector function to an already evaluated argument
+    Value apply(const Value& oldvalue)
+    {
         switch(functionPtr.type)
         {
-            case fn_vector: return functionPtr.get_vector(result);
+            case fn_vector: return functionPtr.get_vector(oldvalue);
             case fn_scalar: 
             default:
 
-            for(int i = 0 ; i < oldvalue.size(); ++i)
-            {
-                result[i] = functionPtr.get(oldvalue[i]);
-            }
+            if (oldvalue.get_kind() == val_string) return oldvalue;
+            Value result;
+            result.resize_for_overwrite(oldvalue.size());
+            functionPtr.get_batch(result.data(),oldvalue.data(),oldvalue.size());
             return result;
         }
     }
@@ -433,9 +620,10 @@ struct InternalFunction : public Function
         return functionPtr.type == fn_expression;
     }
 
-    static InternalFunction* registerInternalFunction(const std::string& name, internalFunction functionPtr)
+    static InternalFunction* registerInternalFunction(Builtins& builtins,const std::string& name, internalFunction functionPtr)
     {
-        return static_cast<InternalFunction*>(Scope::scope->define(name,new InternalFunction(name,functionPtr)));
+        if (functionPtr.type == fn_scalar) functionPtr.batchFunction = math_kernel(name);
+        return static_cast<InternalFunction*>(builtins.define(name,new InternalFunction(name,functionPtr)));
     }
 
     void set_prefixes(const std::string& _prefix,const std::string& _suffix)
@@ -450,6 +638,7 @@ struct FunctionCall : public Expression
     Vector* valueVector;
     Expression* mutation;
     bool is_mutated = false;
+    InternalFunction* builtin = nullptr;    //Set by the resolver when the name is a builtin, printing uses its prefixes
 
     FunctionCall(Variable* _functionIdentifier,Vector* _valueVector) : functionIdentifier(_functionIdentifier), valueVector(_valueVector) 
     {
@@ -457,13 +646,15 @@ struct FunctionCall : public Expression
         dependency(functionIdentifier);
         dependency(valueVector);
     }
-    virtual Value i_evaluate()
+    virtual Value i_evaluate(Scope& scope)
     {
         if (is_mutated)
         {
-            return mutation->evaluate();
+            return mutation->evaluate(scope);
         }
-        Function* function = static_cast<Function*>(functionIdentifier->get());
+        Binding* binding = functionIdentifier->binding(scope);
+        Function* function = static_cast<Function*>(binding->expression);
+        Frame* environment = binding->frame;
         if (function->is_internal)
         {
             InternalFunction* intFunction = static_cast<InternalFunction*>(function);
@@ -471,36 +662,36 @@ struct FunctionCall : public Expression
             {
                 intFunction->evaluate(valueVector,mutation);
                 is_mutated = true;
-                return i_evaluate();
+                return i_evaluate(scope);
             }
         }
-        return function->evaluate(valueVector);
-    }
-    virtual void i_print(std::string & str)
-    {
-        if (is_mutated)
+        //Arguments a native call evaluated before falling back are not evaluated again
+        Value result;
+        std::vector<Value> values;
+        std::vector<bool> evaluated;
+        if (function->native && native_evaluate(scope,function->native,valueVector,result,values,evaluated)) return result;
+        size_t capacity = scope.memoCapacity;
+        if (function->is_pure && capacity) return function->memoized_evaluate(scope,valueVector,environment,capacity,values,evaluated);
+        if (!values.empty()) return function->evaluate_bound(scope,valueVector,values,evaluated,environment);
+        return function->evaluate(scope,valueVector,environment);
+    }
+    //Printed as written, what an expression function turned the call into only shows through its value
+    virtual void i_print(const RenderView& view,OutputSink& str)
+    {
+        if (builtin && builtin->use_special_prefix)
         {
-            mutation->print(str);
+            str += builtin->prefix;
+            valueVector->print_content(view,str);
+            str += builtin->suffix;
             return;
         }
-        Function* function = static_cast<Function*>(functionIdentifier->get());
-        if (function->is_internal)
-        {
-            InternalFunction* internal = static_cast<InternalFunction*>(function);
-            if (internal->use_special_prefix)
-            {
-                str += internal->prefix;
-                valueVector->print_content(str);
-                str += internal->suffix;
-                return;
-            }
-        }
-        functionIdentifier->print(str);
-        valueVector->print(str);
+        functionIdentifier->print(view,str);
+        valueVector->print(view,str);
     }
 };
 
 
-#define m_registerInternalFunction(x) InternalFunction::registerInternalFunction(#x,x);
-#define m_registerInternalSpecialFunction(x,prefix,suffix) { auto* e = InternalFunction::registerInternalFunction(#x,x); e->set_prefixes(prefix,suffix); }
-#define m_registerInternalConstant(x) Scope::scope->define(#x,new Constant(x));
\ No newline at end of file
+//Registration helpers, expect the Builtins table being filled to be named builtins
+#define m_registerInternalFunction(x) InternalFunction::registerInternalFunction(builtins,#x,x);
+#define m_registerInternalSpecialFunction(x,prefix,suffix) { auto* e = InternalFunction::registerInternalFunction(builtins,#x,x); e->set_prefixes(prefix,suffix); }
+#define m_registerInternalConstant(x) builtins.define(#x,new Constant(x));
\ No newline at end of file
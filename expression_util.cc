@@ -2,76 +2,6 @@
 #include "expression_util.h"
 #include "expression_types.h"
 
-void inlist(Expression* current,list<Expression*>& l)
-{
-
-    l.push_front(current);
-    for(Expression* c : current->dependencies)
-    {
-        if (current->getType() == ex_FunctionCall && c->getType() == ex_Variable) continue;
-
-        switch(c->getType())
-        {
-            case ex_Function:
-            case ex_Constant: continue;
-            default: inlist(c,l);
-        }
-    }
-}
-void latexize2(Expression* root,std::string& str,Expression* current = nullptr,bool print = true)
-{
-    if (current == nullptr)
-    {
-        current = root;
-        root->print(str);
-    }
-
-    for(Expression* c : current->dependencies)
-    {
-        if (current->getType() == ex_FunctionCall && c->getType() == ex_Variable) continue;
-
-        switch(c->getType())
-        {
-            case ex_Function:
-            case ex_Constant: continue;
-            default: latexize2(root,str,c,print);
-        }
-    }
-    
-    current->evaluate();
-    if (print)
-    {
-        switch(current->getType())
-        {
-            case ex_Vector: break;
-            default: 
-                    str += " = ";
-                    root->print(str);
-        }
-    }
-
-}
-void latexize(Expression* expression,std::string& str)
-{
-    latexize2(expression,str); return;
-    list<Expression*> expressions;
-    inlist(expression,expressions);
-
-    for(auto it = expressions.begin(); it != expressions.end(); ++it)
-    {
-        expression->print(str);
-        (*it)->evaluate();
-        auto it2 = it;
-        for(; (*it2)->getType() != (*it)->getType(); ++it2)
-        {
-            (*it2)->evaluate();
-        }
-        it = it2;
-        str += " = ";
-    }
-
-    expression->print(str);
-}
 void debug_print_expression(Expression* root,const std::string& prefix)
 {
     auto& dependencies = root->dependencies;
@@ -1,3 +1,2 @@
 #include "expression.h"
-void latexize(Expression* expression,std::string& str);
 void debug_print_expression(Expression* root,const std::string& prefix);
@@ -0,0 +1,99 @@
+#pragma once
+#include "value.h"
+#include <list>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+
+/*
+    Memo table of a pure function, keyed on the evaluated arguments of a call.
+    Holds at most capacity results, the least recently used one is evicted first.
+    Keys are compared bit by bit so 0 and -0 or two different NaNs never share an entry.
+*/
+struct FunctionCache
+{
+    using Key = std::vector<Value>;
+
+    size_t capacity;
+    size_t hits = 0;
+    size_t misses = 0;
+
+    FunctionCache(size_t _capacity) : capacity(_capacity) { }
+
+    const Value* find(const Key& key)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+        {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        order.splice(order.begin(),order,it->second);
+        return &it->second->second;
+    }
+
+    void insert(const Key& key,const Value& value)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            it->second->second = value;
+            order.splice(order.begin(),order,it->second);
+            return;
+        }
+        if (entries.size() == capacity)
+        {
+            entries.erase(order.back().first);
+            order.pop_back();
+        }
+        order.emplace_front(key,value);
+        entries[key] = order.begin();
+    }
+
+    size_t size() const { return entries.size(); }
+
+    private:
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            size_t h = key.size();
+            for (const Value& v : key)
+            {
+                if (v.get_kind() == val_string) h = h * 31 + std::hash<string>()(v.as_string());
+                for (double d : v)
+                {
+                    uint64_t bits;
+                    std::memcpy(&bits,&d,sizeof(bits));
+                    h = h * 1099511628211ull ^ bits;
+                }
+            }
+            return h;
+        }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const Key& a,const Key& b) const
+        {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                if (a[i].get_kind() == val_string || b[i].get_kind() == val_string)
+                {
+                    if (a[i].get_kind() != b[i].get_kind() || a[i].as_string() != b[i].as_string()) return false;
+                    continue;
+                }
+                if (a[i].size() != b[i].size()) return false;
+                if (a[i].size() && std::memcmp(a[i].data(),b[i].data(),a[i].size() * sizeof(double))) return false;
+            }
+            return true;
+        }
+    };
+
+    using Entry = std::pair<Key,Value>;
+    std::list<Entry> order;             //Most recently used first
+    std::unordered_map<Key,std::list<Entry>::iterator,KeyHash,KeyEqual> entries;
+};
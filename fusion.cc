@@ -0,0 +1,265 @@
+#include "fusion.h"
+#include "expression_types.h"
+
+static const size_t fusion_block = 256;         //Elements per block, multiple of 8
+static const size_t fusion_threshold = 64;      //Shorter results use plain Value arithmetic
+
+struct FusedPlan
+{
+    struct Step
+    {
+        int leaf;                               //Index in leaves, -1 for an operation
+        OperationType op;
+        ValueKernels::binaryKernel vv;
+        ValueKernels::vectorScalarKernel vs;
+        ValueKernels::scalarVectorKernel sv;
+    };
+
+    std::vector<Step> steps;                    //Postfix order
+    std::vector<Expression*> leaves;
+    std::vector<Operation*> operations;         //Inner operations, a render may already hold their values
+    size_t depth = 0;                           //Maximum stack height
+};
+
+//Operand of a block operation, either a broadcast scalar or a pointer to the current block
+struct FusedEntry
+{
+    const double* data;
+    double scalar;
+    bool is_scalar;
+};
+
+static bool is_element_wise(Expression* expression)
+{
+    return expression->getType() == ex_Operation && static_cast<Operation*>(expression)->op_type != op_ref;
+}
+
+//Folded and shared operations keep their own value, they are leaves of the chain around them
+static bool is_inlined(Expression* expression)
+{
+    return is_element_wise(expression) && !expression->is_folded && expression->common < 0;
+}
+
+bool is_fusable(Operation* operation)
+{
+    return is_element_wise(operation) && (is_inlined(operation->a) || is_inlined(operation->b));
+}
+
+static double scalar_operation(OperationType op,double a,double b)
+{
+    switch(op)
+    {
+        case op_sum: return scalar_add(a,b);
+        case op_sub: return scalar_sub(a,b);
+        case op_mul: return scalar_mul(a,b);
+        case op_div: return scalar_div(a,b);
+        case op_exp: return scalar_pow(a,b);
+        default: throw std::runtime_error("Invalid operation type");
+    }
+}
+
+static void value_operation(OperationType op,Value& a,const Value& b)
+{
+    switch(op)
+    {
+        case op_sum: a += b; break;
+        case op_sub: a -= b; break;
+        case op_mul: a *= b; break;
+        case op_div: a /= b; break;
+        case op_exp: a ^= b; break;
+        default: throw std::runtime_error("Invalid operation type");
+    }
+}
+
+static void build(FusedPlan& plan,Operation* operation);
+
+static void build_operand(FusedPlan& plan,Expression* expression)
+{
+    if (!is_inlined(expression))
+    {
+        plan.leaves.push_back(expression);
+        plan.steps.push_back({(int)plan.leaves.size() - 1,op_sum,nullptr,nullptr,nullptr});
+        return;
+    }
+    plan.operations.push_back(static_cast<Operation*>(expression));
+    build(plan,static_cast<Operation*>(expression));
+}
+
+static void build(FusedPlan& plan,Operation* operation)
+{
+    build_operand(plan,operation->a);
+    build_operand(plan,operation->b);
+
+    const ValueKernels& k = value_kernels();
+    #define case_kernels(type,name) case type: plan.steps.push_back({-1,type,k.name##_vv,k.name##_vs,k.name##_sv}); break;
+    switch(operation->op_type)
+    {
+        case_kernels(op_sum,add);
+        case_kernels(op_sub,sub);
+        case_kernels(op_mul,mul);
+        case_kernels(op_div,div);
+        case_kernels(op_exp,pow);
+        default: break;
+    }
+    #undef case_kernels
+}
+
+static FusedPlan& plan_for(Operation* operation)
+{
+    if (operation->plan) return *operation->plan;
+
+    FusedPlan* plan = new FusedPlan();
+    build(*plan,operation);
+    size_t height = 0;
+    for (const FusedPlan::Step& step : plan->steps)
+    {
+        height = step.leaf >= 0 ? height + 1 : height - 1;
+        plan->depth = std::max(plan->depth,height);
+    }
+    return *(operation->plan = plan);
+}
+
+//True when a render already evaluated an inner operation, the chain is not fused again around its value
+static bool holds_operands(const FusedPlan& plan)
+{
+    for (Operation* operation : plan.operations) if (operation->pinned && operation->wasEvaluated) return true;
+    return false;
+}
+
+//One operation at a time, every operand through evaluate() so the values held are reused
+static Value evaluate_operands(Scope& scope,Operation* operation)
+{
+    Value a = operation->a->evaluate(scope);
+    value_operation(operation->op_type,a,operation->b->evaluate(scope));
+    return a;
+}
+
+//Evaluates every leaf once and computes the length of the result
+static size_t prepare(Scope& scope,FusedPlan& plan,std::vector<Value>& values,bool& fuse)
+{
+    values.reserve(plan.leaves.size());
+    for (Expression* leaf : plan.leaves) values.push_back(leaf->evaluate(scope));
+
+    std::vector<size_t> sizes;
+    bool strings = false;
+    for (const FusedPlan::Step& step : plan.steps)
+    {
+        if (step.leaf >= 0)
+        {
+            strings |= values[step.leaf].get_kind() == val_string;
+            sizes.push_back(values[step.leaf].size());
+            continue;
+        }
+        size_t b = sizes.back(); sizes.pop_back();
+        size_t a = sizes.back();
+        if (a == 1) sizes.back() = b;
+        else if (b != 1 && b < a) throw std::runtime_error("Vector sizes do not match");
+    }
+    fuse = !strings && sizes.back() >= fusion_threshold;
+    return sizes.back();
+}
+
+static Value evaluate_values(FusedPlan& plan,std::vector<Value>& values)
+{
+    std::vector<Value> stack;
+    for (const FusedPlan::Step& step : plan.steps)
+    {
+        if (step.leaf >= 0) { stack.push_back(std::move(values[step.leaf])); continue; }
+        Value b = std::move(stack.back());
+        stack.pop_back();
+        value_operation(step.op,stack.back(),b);
+    }
+    return std::move(stack.back());
+}
+
+//Runs the plan block by block, the last operation writes into destination when given
+template <typename Sink>
+static void evaluate_blocks(FusedPlan& plan,const std::vector<Value>& values,size_t n,double* destination,Sink sink)
+{
+    thread_local std::vector<double> scratch;
+    scratch.resize(plan.depth * fusion_block);
+    std::vector<FusedEntry> stack(plan.depth);
+
+    for (size_t offset = 0; offset < n; offset += fusion_block)
+    {
+        size_t length = std::min(fusion_block,n - offset);
+        size_t top = 0;
+        for (size_t s = 0; s < plan.steps.size(); s++)
+        {
+            const FusedPlan::Step& step = plan.steps[s];
+            if (step.leaf >= 0)
+            {
+                const Value& v = values[step.leaf];
+                if (v.is_numeric()) stack[top++] = {nullptr,v[0],true};
+                else stack[top++] = {v.data() + offset,0.0,false};
+                continue;
+            }
+
+            const FusedEntry b = stack[--top];
+            FusedEntry& a = stack[top - 1];
+            if (a.is_scalar && b.is_scalar) { a.scalar = scalar_operation(step.op,a.scalar,b.scalar); continue; }
+
+            bool last = s + 1 == plan.steps.size();
+            double* out = last && destination ? destination + offset : scratch.data() + (top - 1) * fusion_block;
+            if (a.is_scalar) step.sv(out,a.scalar,b.data,length);
+            else if (b.is_scalar) step.vs(out,a.data,b.scalar,length);
+            else step.vv(out,a.data,b.data,length);
+            a = {out,0.0,false};
+        }
+        sink(stack[0].data,offset,length);
+    }
+}
+
+Value fused_evaluate(Scope& scope,Operation* operation)
+{
+    FusedPlan& plan = plan_for(operation);
+    if (holds_operands(plan)) return evaluate_operands(scope,operation);
+    std::vector<Value> values;
+    bool fuse;
+    size_t n = prepare(scope,plan,values,fuse);
+    if (!fuse) return evaluate_values(plan,values);
+
+    Value result;
+    result.resize_for_overwrite(n);
+    evaluate_blocks(plan,values,n,result.data(),[](const double*,size_t,size_t) { });
+    return result;
+}
+
+double fused_reduce(Scope& scope,Operation* operation,FusedReduction reduction)
+{
+    const ValueKernels& k = value_kernels();
+    auto reduce = [&](const Value& v) { return reduction == reduce_sum ? k.sum(v.data(),v.size()) : k.prod(v.data(),v.size()); };
+    //An operation with a value of its own, folded, shared or held by a render, is reduced from that value
+    if (!is_inlined(operation) || (operation->pinned && operation->wasEvaluated)) return reduce(operation->evaluate(scope));
+
+    FusedPlan& plan = plan_for(operation);
+    if (holds_operands(plan)) return reduce(evaluate_operands(scope,operation));
+    std::vector<Value> values;
+    bool fuse;
+    size_t n = prepare(scope,plan,values,fuse);
+    if (!fuse) return reduce(evaluate_values(plan,values));
+
+    //Same association as the reduction kernels: 8 lanes, combined, then the tail
+    ValueKernels::laneKernel lanesKernel = reduction == reduce_sum ? k.sum_lanes : k.prod_lanes;
+    double lanes[8];
+    double tail[8];
+    size_t tailLength = 0;
+    evaluate_blocks(plan,values,n,nullptr,[&](const double* data,size_t offset,size_t length)
+    {
+        size_t i = 0;
+        if (offset == 0)
+        {
+            for (int j = 0; j < 8; j++) lanes[j] = data[j];
+            i = 8;
+        }
+        size_t body = (length - i) & ~size_t(7);
+        lanesKernel(lanes,data + i,body);
+        for (i += body; i < length; i++) tail[tailLength++] = data[i];
+    });
+
+    double result = reduction == reduce_sum ? combine_sum(lanes) : combine_prod(lanes);
+    for (size_t i = 0; i < tailLength; i++) result = reduction == reduce_sum ? result + tail[i] : result * tail[i];
+    return result;
+}
+
+void release_fused_plan(FusedPlan* plan) { delete plan; }
@@ -0,0 +1,26 @@
+#pragma once
+#include "value.h"
+
+struct Operation;
+struct Scope;
+struct FusedPlan;
+
+enum FusedReduction { reduce_sum, reduce_prod };
+
+/*
+    Fused evaluation of element wise Operation chains such as a*b + c.
+    The leaves of the chain are evaluated once, then the whole chain is computed in blocks
+    of a few hundred elements so no intermediate vector is ever materialized. Reductions
+    (vsum, vprod) consume the blocks directly and never build the vector they reduce.
+    Short vectors are computed with plain Value arithmetic on the evaluated leaves.
+    Folded and shared operations are leaves of the chains around them. While a render holds
+    the value of an inner operation the chain is evaluated one operation at a time instead.
+*/
+
+//True when the operation has an element wise Operation as a child that is not folded or shared
+bool is_fusable(Operation* operation);
+
+Value fused_evaluate(Scope& scope,Operation* operation);
+double fused_reduce(Scope& scope,Operation* operation,FusedReduction reduction);
+
+void release_fused_plan(FusedPlan* plan);
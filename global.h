@@ -1,2 +1,5 @@
 #pragma once
-#define DEBUG
\ No newline at end of file
+//Traces definitions and the parsed tree on stderr, release builds leave it out
+#ifndef NDEBUG
+#define DEBUG
+#endif
@@ -0,0 +1,181 @@
+#include "incremental.h"
+#include "expression_types.h"
+
+//Collects the document level symbols read by a statement
+struct ReadCollector
+{
+    std::set<int>& reads;
+    size_t depth = 0;                   //Blocks entered below the document
+
+    ReadCollector(std::set<int>& _reads) : reads(_reads) { }
+
+    void collect(Expression* expression)
+    {
+        switch(expression->getType())
+        {
+            case ex_Variable:
+            {
+                Variable* variable = static_cast<Variable*>(expression);
+                if (variable->slot < 0 || variable->depth == (int)depth) reads.insert(variable->symbol);
+                return;
+            }
+            case ex_StringConstant:
+                for (const StringConstant::Segment& segment : static_cast<StringConstant*>(expression)->segments)
+                {
+                    if (segment.variable) collect(segment.variable);
+                }
+                return;
+            case ex_ExpressionBlock:
+                depth++;
+                for (Expression* e : expression->dependencies) collect(e);
+                depth--;
+                return;
+            case ex_Function:
+                collect(static_cast<Function*>(expression)->expressionBlock);
+                return;
+            default:
+                for (Expression* e : expression->dependencies) collect(e);
+        }
+    }
+};
+
+//Repeats the bindings a clean statement would make without evaluating it
+static void replay(Scope& scope,Expression* expression)
+{
+    switch(expression->getType())
+    {
+        case ex_Assignment:
+        {
+            Assignment* assignment = static_cast<Assignment*>(expression);
+            scope.assign(assignment->identifier,assignment->assignment);
+            replay(scope,assignment->assignment);
+            return;
+        }
+        case ex_ExpressionBlock:
+        case ex_Function: return;
+        default:
+            for (Expression* e : expression->dependencies) replay(scope,e);
+    }
+}
+
+IncrementalDocument::IncrementalDocument(Scope& _scope) : scope(_scope)
+{
+    Expression* root = scope.rootExpression;
+    std::vector<Expression*> expressions;
+    if (root->getType() == ex_ExpressionBlock) expressions = static_cast<ExpressionBlock*>(root)->expressions;
+    else expressions.push_back(root);
+
+    for (Expression* expression : expressions)
+    {
+        Statement statement;
+        statement.expression = expression;
+        ReadCollector(statement.reads).collect(expression);
+        if (expression->getType() == ex_Assignment) statement.defines = static_cast<Assignment*>(expression)->identifier->symbol;
+        statements.push_back(statement);
+    }
+}
+
+std::string IncrementalDocument::render()
+{
+    FrameSwitch frame(scope,scope.global);
+    std::string result;
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        Statement& statement = statements[i];
+        if (statement.dirty)
+        {
+            RenderTable table;
+            evaluate_statement(scope,table,statement.expression);
+            statement.output.clear();
+            OutputSink out(statement.output);
+            render_statement(table,statement.expression,out);
+            statement.dirty = false;
+        }
+        else replay(scope,statement.expression);
+
+        result += statement.output;
+        if (i + 1 != statements.size()) result += "\n";
+    }
+    return result;
+}
+
+//Writes the value into the literal of a previous rebind when it has the same shape, so rebinding allocates nothing
+static bool overwrite(Expression* current,Expression* literal,const Value& value)
+{
+    if (current != literal || literal == nullptr || value.is_string()) return false;
+    if (literal->getType() == ex_Constant && value.size() == 1)
+    {
+        static_cast<Constant*>(literal)->v = value[0];
+        return true;
+    }
+    if (literal->getType() != ex_Vector || value.size() == 1) return false;
+    Vector* vector = static_cast<Vector*>(literal);
+    if (vector->size() != value.size()) return false;
+    for (size_t i = 0; i < value.size(); i++) static_cast<Constant*>(vector->at(i))->v = value[i];
+    return true;
+}
+
+void IncrementalDocument::rebind(const std::string& name,const Value& value)
+{
+    int symbol = scope.symbols.intern(name);
+    Statement* target = nullptr;
+    for (Statement& statement : statements) if (statement.defines == symbol) { target = &statement; break; }
+    if (target == nullptr) throw std::runtime_error("Incremental: " + name + " is not assigned at document level");
+
+    //Same nodes the parser builds for a literal so it prints the same way
+    Assignment* assignment = static_cast<Assignment*>(target->expression);
+    if (!overwrite(assignment->assignment,literals[symbol],value))
+    {
+        Expression* replacement;
+        if (value.is_string()) replacement = scope.arena.make<StringConstant>(scope,value);
+        else if (value.size() == 1) replacement = scope.arena.make<Constant>(value[0]);
+        else
+        {
+            Vector* vector = scope.arena.make<Vector>();
+            for (double v : value) vector->add_expression(scope.arena.make<Constant>(v));
+            replacement = vector;
+        }
+        std::replace(assignment->dependencies.begin(),assignment->dependencies.end(),assignment->assignment,replacement);
+        assignment->assignment = literals[symbol] = replacement;
+        assignment->identifier->represents_vector = replacement->getType() == ex_Vector;
+    }
+    target->reads.clear();
+    target->dirty = true;
+
+    //Names whose definitions read a changed name change as well
+    std::set<int> changed = {symbol};
+    bool grown = true;
+    while (grown)
+    {
+        grown = false;
+        for (const Statement& statement : statements)
+        {
+            if (statement.defines < 0 || changed.count(statement.defines)) continue;
+            for (int read : statement.reads)
+            {
+                if (changed.count(read) == 0) continue;
+                changed.insert(statement.defines);
+                grown = true;
+                break;
+            }
+        }
+    }
+    for (Statement& statement : statements)
+    {
+        for (int read : statement.reads) if (changed.count(read)) { statement.dirty = true; break; }
+    }
+
+    //Cached results of pure functions may depend on the old value
+    for (Function* function : scope.pureFunctions)
+    {
+        delete function->cache;
+        function->cache = nullptr;
+    }
+}
+
+size_t IncrementalDocument::dirty_count() const
+{
+    size_t count = 0;
+    for (const Statement& statement : statements) count += statement.dirty;
+    return count;
+}
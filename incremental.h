@@ -0,0 +1,37 @@
+#pragma once
+#include "scope.h"
+#include <set>
+#include <map>
+
+/*
+    Incremental rendering of a parsed document. Every top level statement keeps its
+    rendered text and the set of document level names it reads (directly, through
+    functions or through string interpolation). Rebinding a name marks dirty the
+    statements that depend on it, transitively through the definitions of other names,
+    and the next render only re-evaluates and re-prints those.
+*/
+struct IncrementalDocument
+{
+    struct Statement
+    {
+        Expression* expression;
+        std::set<int> reads;            //Document level symbols
+        int defines = -1;               //Symbol assigned by the statement
+        std::string output;
+        bool dirty = true;
+    };
+
+    Scope& scope;
+    std::vector<Statement> statements;
+    std::map<int,Expression*> literals; //Last literal each name was rebound to, overwritten by the next rebind
+
+    IncrementalDocument(Scope& scope);
+
+    //Renders the dirty statements and returns the whole document
+    std::string render();
+
+    //Replaces the value of the first top level assignment to name
+    void rebind(const std::string& name,const Value& value);
+
+    size_t dirty_count() const;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+
+/*
+    Read only view of a whole file. Regular files are mapped, the pages of the mapping
+    past the end of the file are zero, so the text is always followed by a NUL as the
+    lexer expects. Anything else (pipes, terminals) is read into memory.
+*/
+struct MappedFile
+{
+    MappedFile(const std::string& path)
+    {
+        int fd = ::open(path.c_str(),O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        if (::fstat(fd,&st) != 0 || !S_ISREG(st.st_mode) || !map(fd,st.st_size)) read_all(fd);
+        ::close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { if (mapping) ::munmap(mapping,mapped); }
+
+    const char* data() const { return text; }
+    size_t size() const { return length; }
+
+    private:
+
+    void* mapping = nullptr;
+    size_t mapped = 0;
+    std::string contents;               //Files that cannot be mapped
+    const char* text = nullptr;
+    size_t length = 0;
+
+    //The file is mapped over zero pages one byte longer than it
+    bool map(int fd,size_t size)
+    {
+        size_t page = ::sysconf(_SC_PAGESIZE);
+        size_t total = (size + page) / page * page;
+        void* base = ::mmap(nullptr,total,PROT_READ,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+        if (base == MAP_FAILED) return false;
+        if (size && ::mmap(base,size,PROT_READ,MAP_PRIVATE | MAP_FIXED,fd,0) == MAP_FAILED)
+        {
+            ::munmap(base,total);
+            return false;
+        }
+        mapping = base;
+        mapped = total;
+        text = static_cast<const char*>(base);
+        length = size;
+        return true;
+    }
+
+    void read_all(int fd)
+    {
+        char buffer[65536];
+        for (;;)
+        {
+            ssize_t n = ::read(fd,buffer,sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            contents.append(buffer,n);
+        }
+        text = contents.c_str();
+        length = contents.size();
+    }
+};
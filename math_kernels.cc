@@ -0,0 +1,525 @@
+#include "math_kernels.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EXPRESS_X86
+#endif
+
+static inline uint64_t bits_of(double x) { uint64_t b; std::memcpy(&b,&x,sizeof(b)); return b; }
+static inline double from_bits(uint64_t b) { double x; std::memcpy(&x,&b,sizeof(x)); return x; }
+
+//Adding it rounds a double below 2^51 to the nearest integer, which is then held in the low bits
+static const double round_magic = 6755399441055744.0;
+static const double two52 = 4503599627370496.0;
+static const uint64_t mantissa_mask = 0x000fffffffffffffull;
+static const uint64_t one_bits = 0x3ff0000000000000ull;
+
+//Reduced ranges, anything else is computed by libm
+static const double trig_limit = 8192.0;
+static const double trig_tiny = 0x1p-27;        //sin x and tan x round to x below it
+static const double exp_min = -708.0, exp_max = 709.0;
+static const double exp2_min = -1022.0, exp2_max = 1023.0;
+
+//Largest error of each kernel measured against the exact result, in ulps
+static const double trig_ulps = 2.5, tan_ulps = 3.5;
+static const double exp_ulps = 1.5, log_ulps = 1.0, log_base_ulps = 2.0;
+
+//pi/2 in parts of 33 bits, their products with a quadrant below 2^20 are exact
+static const double two_over_pi = 6.36619772367581382433e-01;
+static const double pio2_1 = 1.57079632673412561417e+00;
+static const double pio2_2 = 6.07710050630396597660e-11;
+static const double pio2_3 = 2.02226624871116645580e-21;
+static const double pio2_3t = 8.47842766036889956997e-32;
+
+//Minimax polynomials of fdlibm on [-pi/4,pi/4]
+static const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03, S3 = -1.98412698298579493134e-04,
+                    S4 = 2.75573137070700676789e-06, S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+static const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03, C3 = 2.48015872894767294178e-05,
+                    C4 = -2.75573143513906633035e-07, C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+
+static const double ln2_hi = 6.93147180369123816490e-01, ln2_lo = 1.90821492927058770002e-10;
+static const double log2e = 1.44269504088896338700e+00;
+static const double log10_2hi = 3.01029995663611771306e-01, log10_2lo = 3.69423907715893078616e-13;
+static const double log10e = 4.34294481903251816668e-01;
+
+//Taylor series of e^r on |r| <= ln(2)/2, highest degree first
+static const int exp_degree = 13;
+static const double exp_coefficients[exp_degree + 1] = {
+    1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0,
+    1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0
+};
+
+//log(1+f) = f - f^2/2 + s (f^2/2 + R(s^2)) with s = f/(2+f), minimax polynomial of fdlibm
+static const double Lg1 = 6.666666666666735130e-01, Lg2 = 3.999999999940941908e-01, Lg3 = 2.857142874366239149e-01,
+                    Lg4 = 2.222219843214978396e-01, Lg5 = 1.818357216161805012e-01, Lg6 = 1.531383769920937332e-01,
+                    Lg7 = 1.479819860511658591e-01;
+
+//Element functions, the portable kernels and the tails of the vector ones
+
+static inline double reduce_quadrant(double x,uint64_t& quadrant)
+{
+    double t = x * two_over_pi + round_magic;
+    double q = t - round_magic;
+    quadrant = bits_of(t);
+    return (((x - q * pio2_1) - q * pio2_2) - q * pio2_3) - q * pio2_3t;
+}
+
+static inline double sin_polynomial(double r)
+{
+    double z = r * r;
+    double p = S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)));
+    return r + r * z * (S1 + z * p);
+}
+
+static inline double cos_polynomial(double r)
+{
+    double z = r * r;
+    double p = z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    double hz = 0.5 * z, w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + z * p);
+}
+
+//sin of x when the quadrant is even, cos when it is odd, negated in the upper half turn
+static inline double quadrant_select(double s,double c,uint64_t quadrant)
+{
+    double v = quadrant & 1 ? c : s;
+    return from_bits(bits_of(v) ^ ((quadrant >> 1) << 63));
+}
+
+static double sin_element(double x)
+{
+    double ax = std::fabs(x);
+    if (!(ax <= trig_limit)) return std::sin(x);
+    if (ax < trig_tiny) return x;
+    uint64_t quadrant;
+    double r = reduce_quadrant(x,quadrant);
+    return quadrant_select(sin_polynomial(r),cos_polynomial(r),quadrant);
+}
+
+static double cos_element(double x)
+{
+    if (!(std::fabs(x) <= trig_limit)) return std::cos(x);
+    uint64_t quadrant;
+    double r = reduce_quadrant(x,quadrant);
+    return quadrant_select(sin_polynomial(r),cos_polynomial(r),quadrant + 1);
+}
+
+static double tan_element(double x)
+{
+    double ax = std::fabs(x);
+    if (!(ax <= trig_limit)) return std::tan(x);
+    if (ax < trig_tiny) return x;
+    uint64_t quadrant;
+    double r = reduce_quadrant(x,quadrant);
+    double s = sin_polynomial(r), c = cos_polynomial(r);
+    double t = quadrant & 1 ? c / s : s / c;
+    return from_bits(bits_of(t) ^ (quadrant << 63));
+}
+
+static inline double exp_polynomial(double r)
+{
+    double p = exp_coefficients[0];
+    for (int k = 1; k <= exp_degree; k++) p = p * r + exp_coefficients[k];
+    return p;
+}
+
+//p 2^n, where t holds n in its low bits
+static inline double exp_scale(double p,double t) { return from_bits(bits_of(p) + ((bits_of(t) - bits_of(round_magic)) << 52)); }
+
+static double exp_element(double x)
+{
+    if (!(x >= exp_min && x <= exp_max)) return std::exp(x);
+    double t = x * log2e + round_magic;
+    double n = t - round_magic;
+    double r = (x - n * ln2_hi) - n * ln2_lo;
+    return exp_scale(exp_polynomial(r),t);
+}
+
+static double exp2_element(double x)
+{
+    if (!(x >= exp2_min && x <= exp2_max)) return std::exp2(x);
+    double t = x + round_magic;
+    double n = t - round_magic;
+    double r = (x - n) * M_LN2;
+    return exp_scale(exp_polynomial(r),t);
+}
+
+//x = 2^k (1 + f) with 1 + f in [sqrt(2)/2,sqrt(2)), log(1 + f) = f - (hfsq - tail)
+struct LogParts
+{
+    double k, f, hfsq, tail;
+};
+
+static inline LogParts log_reduce(double x)
+{
+    uint64_t b = bits_of(x);
+    double m = from_bits((b & mantissa_mask) | one_bits);
+    double e = from_bits((b >> 52) | bits_of(two52)) - two52;
+    bool big = m > M_SQRT2;
+    m = big ? m * 0.5 : m;
+
+    LogParts parts;
+    parts.k = (e - 1023.0) + (big ? 1.0 : 0.0);
+    parts.f = m - 1.0;
+    parts.hfsq = 0.5 * parts.f * parts.f;
+    double s = parts.f / (2.0 + parts.f);
+    double z = s * s, w = z * z;
+    double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    parts.tail = s * (parts.hfsq + (t2 + t1));
+    return parts;
+}
+
+static inline bool log_range(double x) { return x >= DBL_MIN && x <= DBL_MAX; }
+
+static double log_element(double x)
+{
+    if (!log_range(x)) return std::log(x);
+    LogParts p = log_reduce(x);
+    return p.k * ln2_hi - ((p.hfsq - (p.tail + p.k * ln2_lo)) - p.f);
+}
+
+static double log2_element(double x)
+{
+    if (!log_range(x)) return std::log2(x);
+    LogParts p = log_reduce(x);
+    return p.k + (p.f - (p.hfsq - p.tail)) * log2e;
+}
+
+static double log10_element(double x)
+{
+    if (!log_range(x)) return std::log10(x);
+    LogParts p = log_reduce(x);
+    return p.k * log10_2hi + (p.k * log10_2lo + (p.f - (p.hfsq - p.tail)) * log10e);
+}
+
+//libm, used when a kernel is not accurate enough and for the arguments kernels do not cover
+
+#define LIBM_KERNEL(name) \
+static void name##_libm(double* out,const double* a,size_t n) { for (size_t i = 0; i < n; i++) out[i] = std::name(a[i]); }
+
+LIBM_KERNEL(sin)
+LIBM_KERNEL(cos)
+LIBM_KERNEL(tan)
+LIBM_KERNEL(exp)
+LIBM_KERNEL(exp2)
+LIBM_KERNEL(log)
+LIBM_KERNEL(log2)
+LIBM_KERNEL(log10)
+LIBM_KERNEL(sqrt)
+LIBM_KERNEL(abs)
+LIBM_KERNEL(ceil)
+LIBM_KERNEL(floor)
+
+#undef LIBM_KERNEL
+
+//Portable implementation
+
+#define PORTABLE_KERNEL(name) \
+static void name##_portable(double* out,const double* a,size_t n) { for (size_t i = 0; i < n; i++) out[i] = name##_element(a[i]); }
+
+PORTABLE_KERNEL(sin)
+PORTABLE_KERNEL(cos)
+PORTABLE_KERNEL(tan)
+PORTABLE_KERNEL(exp)
+PORTABLE_KERNEL(exp2)
+PORTABLE_KERNEL(log)
+PORTABLE_KERNEL(log2)
+PORTABLE_KERNEL(log10)
+
+#undef PORTABLE_KERNEL
+
+static const MathKernels portableKernels = {
+    "portable", 0,
+    sin_portable, cos_portable, tan_portable, exp_portable, exp2_portable,
+    log_portable, log2_portable, log10_portable,
+    sqrt_libm, abs_libm, ceil_libm, floor_libm
+};
+
+#ifdef EXPRESS_X86
+
+//AVX2, four lanes, the same operations as the element functions
+
+__attribute__((target("avx2"))) static inline __m256d reduce_quadrant_lanes(__m256d x,__m256i& quadrant)
+{
+    __m256d magic = _mm256_set1_pd(round_magic);
+    __m256d t = _mm256_add_pd(_mm256_mul_pd(x,_mm256_set1_pd(two_over_pi)),magic);
+    __m256d q = _mm256_sub_pd(t,magic);
+    quadrant = _mm256_castpd_si256(t);
+    __m256d r = _mm256_sub_pd(x,_mm256_mul_pd(q,_mm256_set1_pd(pio2_1)));
+    r = _mm256_sub_pd(r,_mm256_mul_pd(q,_mm256_set1_pd(pio2_2)));
+    r = _mm256_sub_pd(r,_mm256_mul_pd(q,_mm256_set1_pd(pio2_3)));
+    return _mm256_sub_pd(r,_mm256_mul_pd(q,_mm256_set1_pd(pio2_3t)));
+}
+
+//a + b c
+__attribute__((target("avx2"))) static inline __m256d multiply_add(__m256d a,__m256d b,double c) { return _mm256_add_pd(a,_mm256_mul_pd(b,_mm256_set1_pd(c))); }
+__attribute__((target("avx2"))) static inline __m256d horner(__m256d z,double c,__m256d p) { return _mm256_add_pd(_mm256_set1_pd(c),_mm256_mul_pd(z,p)); }
+
+__attribute__((target("avx2"))) static inline __m256d sin_polynomial_lanes(__m256d r)
+{
+    __m256d z = _mm256_mul_pd(r,r);
+    __m256d p = horner(z,S2,horner(z,S3,horner(z,S4,multiply_add(_mm256_set1_pd(S5),z,S6))));
+    return _mm256_add_pd(r,_mm256_mul_pd(_mm256_mul_pd(r,z),horner(z,S1,p)));
+}
+
+__attribute__((target("avx2"))) static inline __m256d cos_polynomial_lanes(__m256d r)
+{
+    __m256d z = _mm256_mul_pd(r,r);
+    __m256d p = _mm256_mul_pd(z,horner(z,C1,horner(z,C2,horner(z,C3,horner(z,C4,multiply_add(_mm256_set1_pd(C5),z,C6))))));
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d hz = _mm256_mul_pd(_mm256_set1_pd(0.5),z), w = _mm256_sub_pd(one,hz);
+    return _mm256_add_pd(w,_mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(one,w),hz),_mm256_mul_pd(z,p)));
+}
+
+__attribute__((target("avx2"))) static inline __m256d quadrant_select_lanes(__m256d s,__m256d c,__m256i quadrant)
+{
+    __m256d swap = _mm256_castsi256_pd(_mm256_slli_epi64(quadrant,63));
+    __m256d negate = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_srli_epi64(quadrant,1),63));
+    return _mm256_xor_pd(_mm256_blendv_pd(s,c,swap),negate);
+}
+
+__attribute__((target("avx2"))) static inline __m256d absolute(__m256d x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0),x); }
+
+__attribute__((target("avx2"))) static inline __m256d trig_outside(__m256d ax) { return _mm256_cmp_pd(ax,_mm256_set1_pd(trig_limit),_CMP_NLE_UQ); }
+__attribute__((target("avx2"))) static inline __m256d trig_small(__m256d ax) { return _mm256_cmp_pd(ax,_mm256_set1_pd(trig_tiny),_CMP_LT_OQ); }
+
+__attribute__((target("avx2"))) static inline __m256d sin_lanes(__m256d x,__m256d& outside)
+{
+    __m256d ax = absolute(x);
+    outside = trig_outside(ax);
+    __m256i quadrant;
+    __m256d r = reduce_quadrant_lanes(x,quadrant);
+    __m256d y = quadrant_select_lanes(sin_polynomial_lanes(r),cos_polynomial_lanes(r),quadrant);
+    return _mm256_blendv_pd(y,x,trig_small(ax));
+}
+
+__attribute__((target("avx2"))) static inline __m256d cos_lanes(__m256d x,__m256d& outside)
+{
+    outside = trig_outside(absolute(x));
+    __m256i quadrant;
+    __m256d r = reduce_quadrant_lanes(x,quadrant);
+    return quadrant_select_lanes(sin_polynomial_lanes(r),cos_polynomial_lanes(r),_mm256_add_epi64(quadrant,_mm256_set1_epi64x(1)));
+}
+
+__attribute__((target("avx2"))) static inline __m256d tan_lanes(__m256d x,__m256d& outside)
+{
+    __m256d ax = absolute(x);
+    outside = trig_outside(ax);
+    __m256i quadrant;
+    __m256d r = reduce_quadrant_lanes(x,quadrant);
+    __m256d s = sin_polynomial_lanes(r), c = cos_polynomial_lanes(r);
+    __m256d odd = _mm256_castsi256_pd(_mm256_slli_epi64(quadrant,63));
+    __m256d t = _mm256_div_pd(_mm256_blendv_pd(s,c,odd),_mm256_blendv_pd(c,s,odd));
+    return _mm256_blendv_pd(_mm256_xor_pd(t,odd),x,trig_small(ax));
+}
+
+__attribute__((target("avx2"))) static inline __m256d exp_polynomial_lanes(__m256d r)
+{
+    __m256d p = _mm256_set1_pd(exp_coefficients[0]);
+    for (int k = 1; k <= exp_degree; k++) p = _mm256_add_pd(_mm256_mul_pd(p,r),_mm256_set1_pd(exp_coefficients[k]));
+    return p;
+}
+
+__attribute__((target("avx2"))) static inline __m256d exp_scale_lanes(__m256d p,__m256d t)
+{
+    __m256i n = _mm256_sub_epi64(_mm256_castpd_si256(t),_mm256_castpd_si256(_mm256_set1_pd(round_magic)));
+    return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(p),_mm256_slli_epi64(n,52)));
+}
+
+//Lanes that are not in [low,high], nan included
+__attribute__((target("avx2"))) static inline __m256d range_outside(__m256d x,double low,double high)
+{
+    return _mm256_or_pd(_mm256_cmp_pd(x,_mm256_set1_pd(low),_CMP_NGE_UQ),_mm256_cmp_pd(x,_mm256_set1_pd(high),_CMP_NLE_UQ));
+}
+
+__attribute__((target("avx2"))) static inline __m256d exp_lanes(__m256d x,__m256d& outside)
+{
+    outside = range_outside(x,exp_min,exp_max);
+    __m256d magic = _mm256_set1_pd(round_magic);
+    __m256d t = _mm256_add_pd(_mm256_mul_pd(x,_mm256_set1_pd(log2e)),magic);
+    __m256d n = _mm256_sub_pd(t,magic);
+    __m256d r = _mm256_sub_pd(_mm256_sub_pd(x,_mm256_mul_pd(n,_mm256_set1_pd(ln2_hi))),_mm256_mul_pd(n,_mm256_set1_pd(ln2_lo)));
+    return exp_scale_lanes(exp_polynomial_lanes(r),t);
+}
+
+__attribute__((target("avx2"))) static inline __m256d exp2_lanes(__m256d x,__m256d& outside)
+{
+    outside = range_outside(x,exp2_min,exp2_max);
+    __m256d magic = _mm256_set1_pd(round_magic);
+    __m256d t = _mm256_add_pd(x,magic);
+    __m256d n = _mm256_sub_pd(t,magic);
+    __m256d r = _mm256_mul_pd(_mm256_sub_pd(x,n),_mm256_set1_pd(M_LN2));
+    return exp_scale_lanes(exp_polynomial_lanes(r),t);
+}
+
+struct LogLanes
+{
+    __m256d k, f, hfsq, tail;
+};
+
+__attribute__((target("avx2"))) static inline LogLanes log_reduce_lanes(__m256d x)
+{
+    __m256i b = _mm256_castpd_si256(x);
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(b,_mm256_set1_epi64x(mantissa_mask)),_mm256_set1_epi64x(one_bits)));
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(b,52),_mm256_set1_epi64x(bits_of(two52)))),_mm256_set1_pd(two52));
+    __m256d big = _mm256_cmp_pd(m,_mm256_set1_pd(M_SQRT2),_CMP_GT_OQ);
+    m = _mm256_blendv_pd(m,_mm256_mul_pd(m,_mm256_set1_pd(0.5)),big);
+
+    LogLanes parts;
+    __m256d one = _mm256_set1_pd(1.0);
+    parts.k = _mm256_add_pd(_mm256_sub_pd(e,_mm256_set1_pd(1023.0)),_mm256_and_pd(big,one));
+    parts.f = _mm256_sub_pd(m,one);
+    parts.hfsq = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5),parts.f),parts.f);
+    __m256d s = _mm256_div_pd(parts.f,_mm256_add_pd(_mm256_set1_pd(2.0),parts.f));
+    __m256d z = _mm256_mul_pd(s,s), w = _mm256_mul_pd(z,z);
+    __m256d t1 = _mm256_mul_pd(w,horner(w,Lg2,horner(w,Lg4,_mm256_set1_pd(Lg6))));
+    __m256d t2 = _mm256_mul_pd(z,horner(w,Lg1,horner(w,Lg3,horner(w,Lg5,_mm256_set1_pd(Lg7)))));
+    parts.tail = _mm256_mul_pd(s,_mm256_add_pd(parts.hfsq,_mm256_add_pd(t2,t1)));
+    return parts;
+}
+
+//f - (hfsq - tail)
+__attribute__((target("avx2"))) static inline __m256d log_mantissa(const LogLanes& p) { return _mm256_sub_pd(p.f,_mm256_sub_pd(p.hfsq,p.tail)); }
+
+__attribute__((target("avx2"))) static inline __m256d log_lanes(__m256d x,__m256d& outside)
+{
+    outside = range_outside(x,DBL_MIN,DBL_MAX);
+    LogLanes p = log_reduce_lanes(x);
+    __m256d low = _mm256_add_pd(p.tail,_mm256_mul_pd(p.k,_mm256_set1_pd(ln2_lo)));
+    return _mm256_sub_pd(_mm256_mul_pd(p.k,_mm256_set1_pd(ln2_hi)),_mm256_sub_pd(_mm256_sub_pd(p.hfsq,low),p.f));
+}
+
+__attribute__((target("avx2"))) static inline __m256d log2_lanes(__m256d x,__m256d& outside)
+{
+    outside = range_outside(x,DBL_MIN,DBL_MAX);
+    LogLanes p = log_reduce_lanes(x);
+    return _mm256_add_pd(p.k,_mm256_mul_pd(log_mantissa(p),_mm256_set1_pd(log2e)));
+}
+
+__attribute__((target("avx2"))) static inline __m256d log10_lanes(__m256d x,__m256d& outside)
+{
+    outside = range_outside(x,DBL_MIN,DBL_MAX);
+    LogLanes p = log_reduce_lanes(x);
+    __m256d low = _mm256_add_pd(_mm256_mul_pd(p.k,_mm256_set1_pd(log10_2lo)),_mm256_mul_pd(log_mantissa(p),_mm256_set1_pd(log10e)));
+    return _mm256_add_pd(_mm256_mul_pd(p.k,_mm256_set1_pd(log10_2hi)),low);
+}
+
+//The lanes outside of the range of a kernel are computed again by its element function, out may be a
+#define AVX2_KERNEL(name) \
+__attribute__((target("avx2"))) static void name##_avx2(double* out,const double* a,size_t n) \
+{ \
+    size_t i = 0; \
+    for (; i + 4 <= n; i += 4) \
+    { \
+        __m256d x = _mm256_loadu_pd(a + i), outside; \
+        _mm256_storeu_pd(out + i,name##_lanes(x,outside)); \
+        if (int lanes = _mm256_movemask_pd(outside)) \
+        { \
+            double values[4]; \
+            _mm256_storeu_pd(values,x); \
+            for (int j = 0; j < 4; j++) if (lanes & (1 << j)) out[i + j] = name##_element(values[j]); \
+        } \
+    } \
+    for (; i < n; i++) out[i] = name##_element(a[i]); \
+}
+
+AVX2_KERNEL(sin)
+AVX2_KERNEL(cos)
+AVX2_KERNEL(tan)
+AVX2_KERNEL(exp)
+AVX2_KERNEL(exp2)
+AVX2_KERNEL(log)
+AVX2_KERNEL(log2)
+AVX2_KERNEL(log10)
+
+#undef AVX2_KERNEL
+
+#define AVX2_EXACT_KERNEL(name,expression) \
+__attribute__((target("avx2"))) static void name##_avx2(double* out,const double* a,size_t n) \
+{ \
+    size_t i = 0; \
+    for (; i + 4 <= n; i += 4) \
+    { \
+        __m256d x = _mm256_loadu_pd(a + i); \
+        _mm256_storeu_pd(out + i,expression); \
+    } \
+    name##_libm(out + i,a + i,n - i); \
+}
+
+AVX2_EXACT_KERNEL(sqrt,_mm256_sqrt_pd(x))
+AVX2_EXACT_KERNEL(abs,absolute(x))
+AVX2_EXACT_KERNEL(ceil,_mm256_round_pd(x,_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC))
+AVX2_EXACT_KERNEL(floor,_mm256_round_pd(x,_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC))
+
+#undef AVX2_EXACT_KERNEL
+
+static const MathKernels avx2Kernels = {
+    "avx2", 0,
+    sin_avx2, cos_avx2, tan_avx2, exp_avx2, exp2_avx2,
+    log_avx2, log2_avx2, log10_avx2,
+    sqrt_avx2, abs_avx2, ceil_avx2, floor_avx2
+};
+
+#endif
+
+struct MathFunction
+{
+    const char* name;
+    MathKernels::mapKernel MathKernels::* kernel;
+    MathKernels::mapKernel libm;
+    double ulps;
+};
+
+static const MathFunction mathFunctions[] = {
+    {"sin",&MathKernels::sin,sin_libm,trig_ulps},
+    {"cos",&MathKernels::cos,cos_libm,trig_ulps},
+    {"tan",&MathKernels::tan,tan_libm,tan_ulps},
+    {"exp",&MathKernels::exp,exp_libm,exp_ulps},
+    {"exp2",&MathKernels::exp2,exp2_libm,exp_ulps},
+    {"log",&MathKernels::log,log_libm,log_ulps},
+    {"log2",&MathKernels::log2,log2_libm,log_base_ulps},
+    {"log10",&MathKernels::log10,log10_libm,log_base_ulps},
+    {"sqrt",&MathKernels::sqrt,sqrt_libm,0},
+    {"abs",&MathKernels::abs,abs_libm,0},
+    {"ceil",&MathKernels::ceil,ceil_libm,0},
+    {"floor",&MathKernels::floor,floor_libm,0}
+};
+
+static MathKernels select_math_kernels()
+{
+    MathKernels kernels = portableKernels;
+#ifdef EXPRESS_X86
+    const char* forced = std::getenv("EXPRESS_SIMD");
+    bool allowAvx2 = !forced || std::strcmp(forced,"avx2") == 0;
+    __builtin_cpu_init();
+    if (allowAvx2 && __builtin_cpu_supports("avx2")) kernels = avx2Kernels;
+#endif
+
+    const char* bound = std::getenv("EXPRESS_ULP");
+    kernels.ulpBound = bound ? std::strtod(bound,nullptr) : 4.0;
+    for (const MathFunction& function : mathFunctions)
+    {
+        if (function.ulps > kernels.ulpBound) kernels.*function.kernel = function.libm;
+    }
+    return kernels;
+}
+
+const MathKernels& math_kernels()
+{
+    static const MathKernels kernels = select_math_kernels();
+    return kernels;
+}
+
+MathKernels::mapKernel math_kernel(const std::string& name)
+{
+    for (const MathFunction& function : mathFunctions)
+    {
+        if (name == function.name) return math_kernels().*function.kernel;
+    }
+    return nullptr;
+}
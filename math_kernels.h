@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/*
+    Batch implementations of the scalar builtins, applied to a whole vector per call.
+    The transcendental functions are polynomial approximations after a range reduction,
+    computed with the same operations in the same order by every implementation, so avx2
+    and portable agree bit for bit. Arguments outside the reduced range (huge angles, inf,
+    nan, subnormals, overflowing exponentials) are handed to libm one by one.
+    EXPRESS_ULP=<bound> sets the largest error in ulps a kernel may have, a function whose
+    kernel is less accurate than that is computed with libm. sqrt, abs, ceil and floor are
+    always exact. avx2 is used when the cpu has it and EXPRESS_SIMD does not ask for
+    something else, see value_kernels.h.
+*/
+struct MathKernels
+{
+    using mapKernel = void (*) (double* out,const double* a,size_t n);
+
+    const char* name;
+    double ulpBound;
+
+    mapKernel sin, cos, tan, exp, exp2, log, log2, log10, sqrt, abs, ceil, floor;
+};
+
+const MathKernels& math_kernels();
+
+//Kernel of the builtin with that name, nullptr when it has none
+MathKernels::mapKernel math_kernel(const std::string& name);
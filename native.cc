@@ -0,0 +1,511 @@
+#include "native.h"
+#include "expression_types.h"
+#include "ast_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <set>
+#include <dlfcn.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+static const size_t native_max_parameters = 16;
+static const size_t native_max_globals = 64;
+static const char* native_compiler = "g++";
+static const char* native_flags[] = { "-std=c++17", "-O2", "-ffp-contract=off", "-fPIC", "-shared" };
+
+using nativeEntry = double (*) (const double* arguments,const double* globals);
+using nativeLink = void (*) (const MathKernels::mapKernel* kernels);
+
+struct NativeFunction
+{
+    nativeEntry entry = nullptr;
+    size_t parameters = 0;
+    std::vector<bool> forced;                   //Parameters the result depends on, the other arguments are not evaluated
+    std::vector<std::pair<int,int>> globals;    //Index in the globals array and slot in the document frame, of the names it depends on
+};
+
+struct NativeModule
+{
+    void* handle = nullptr;
+    std::vector<NativeFunction> functions;
+
+    ~NativeModule() { if (handle) ::dlclose(handle); }
+};
+
+//One document level function on its way to C++
+struct NativeCandidate
+{
+    Function* function;
+    bool eligible = true;
+    std::string code;
+    //What the tree walker forces to compute the result, see NativeCompiler::force()
+    std::set<size_t> forcedParameters;
+    std::set<int> forcedReads;          //Document level names, also through the functions called
+};
+
+struct NativeCompiler
+{
+    Scope& scope;
+    const Layout& globalLayout;
+    std::vector<NativeCandidate> candidates;
+    std::map<int,size_t> bySymbol;
+    std::map<int,int> globals;                  //Name to index in the globals array
+    std::vector<InternalFunction*> builtins;    //Kernels linked into the module, in order
+
+    //State of the body being emitted
+    NativeCandidate* current = nullptr;
+    std::set<int> defined;
+    bool ok = true;
+
+    NativeCompiler(Scope& _scope,ExpressionBlock* root) : scope(_scope), globalLayout(root->layout)
+    {
+        for (Expression* statement : root->expressions)
+        {
+            if (statement->getType() != ex_Assignment) continue;
+            Assignment* assignment = static_cast<Assignment*>(statement);
+            if (assignment->assignment->getType() != ex_Function) continue;
+            Function* function = static_cast<Function*>(assignment->assignment);
+            if (!function->is_pure || function->parameterVector->size() > native_max_parameters) continue;
+            bySymbol[assignment->identifier->symbol] = candidates.size();
+            candidates.push_back({function});
+        }
+    }
+
+    std::string fail() { ok = false; return std::string(); }
+
+    static std::string literal(double v)
+    {
+        char buffer[64];
+        std::snprintf(buffer,sizeof(buffer),"%a",v);
+        return buffer;
+    }
+
+    static std::string slot_name(int slot) { return "s" + std::to_string(slot); }
+
+    std::string number(const Value& v)
+    {
+        if (v.get_kind() == val_string || !v.is_numeric() || !std::isfinite(v[0])) return fail();
+        return literal(v[0]);
+    }
+
+    //Chain of the body: the body itself, the document, the builtins
+    std::string emit_variable(Variable* variable)
+    {
+        switch(variable->depth)
+        {
+            case 0:
+                if (defined.count(variable->slot) == 0) return fail();
+                return slot_name(variable->slot);
+            case 1:
+            {
+                if (bySymbol.count(variable->symbol) || globalLayout.count(variable->symbol) == 0) return fail();
+                if (globals.count(variable->symbol) == 0)
+                {
+                    int index = globals.size();
+                    globals[variable->symbol] = index;
+                }
+                return "g[" + std::to_string(globals[variable->symbol]) + "]";
+            }
+            case 2:
+            {
+                Expression* builtin = scope.builtins.slots[variable->slot].expression;
+                if (builtin->getType() != ex_Constant) return fail();
+                return number(static_cast<Constant*>(builtin)->v);
+            }
+            default: return fail();
+        }
+    }
+
+    std::string emit_call(FunctionCall* call)
+    {
+        Variable* identifier = call->functionIdentifier;
+        Vector* arguments = call->valueVector;
+        if (identifier->depth == 2)
+        {
+            Expression* builtin = scope.builtins.slots[identifier->slot].expression;
+            if (builtin->getType() != ex_InternalFunction || arguments->size() != 1) return fail();
+            InternalFunction* function = static_cast<InternalFunction*>(builtin);
+            if (function->functionPtr.type != fn_scalar || function->functionPtr.batchFunction == nullptr) return fail();
+            size_t kernel = std::find(builtins.begin(),builtins.end(),function) - builtins.begin();
+            if (kernel == builtins.size()) builtins.push_back(function);
+            return "call(" + std::to_string(kernel) + "," + emit(arguments->at(0)) + ")";
+        }
+        if (identifier->depth != 1) return fail();
+        auto it = bySymbol.find(identifier->symbol);
+        if (it == bySymbol.end() || !candidates[it->second].eligible) return fail();
+        if (arguments->size() != candidates[it->second].function->parameterVector->size()) return fail();
+        std::string code = "f" + std::to_string(it->second) + "(g";
+        for (Expression* argument : arguments->variables) code += "," + emit(argument);
+        return code + ")";
+    }
+
+    std::string emit(Expression* expression)
+    {
+        if (!ok) return std::string();
+        switch(expression->getType())
+        {
+            case ex_Constant: return number(static_cast<Constant*>(expression)->v);
+            case ex_Variable: return emit_variable(static_cast<Variable*>(expression));
+            case ex_Vector:
+            {
+                Vector* vector = static_cast<Vector*>(expression);
+                return vector->size() == 1 ? emit(vector->at(0)) : fail();
+            }
+            case ex_Operation:
+            {
+                Operation* operation = static_cast<Operation*>(expression);
+                std::string a = emit(operation->a), b = emit(operation->b);
+                switch(operation->op_type)
+                {
+                    case op_sum: return "(" + a + " + " + b + ")";
+                    case op_sub: return "(" + a + " - " + b + ")";
+                    case op_mul: return "(" + a + " * " + b + ")";
+                    case op_div: return "(" + a + " / " + b + ")";
+                    case op_exp: return "std::pow(" + a + "," + b + ")";
+                    default: return fail();
+                }
+            }
+            case ex_FunctionCall: return emit_call(static_cast<FunctionCall*>(expression));
+            default: return fail();
+        }
+    }
+
+    std::string signature(size_t index)
+    {
+        Function* function = candidates[index].function;
+        std::string code = "static double f" + std::to_string(index) + "(const double* g";
+        for (Expression* parameter : function->parameterVector->variables) code += ",double " + slot_name(static_cast<Variable*>(parameter)->slot);
+        return code + ")";
+    }
+
+    //Locals are assigned once before they are read, the body ends with the value it returns
+    bool emit_function(size_t index)
+    {
+        NativeCandidate& candidate = candidates[index];
+        current = &candidate;
+        defined.clear();
+        ok = true;
+        for (Expression* parameter : candidate.function->parameterVector->variables) defined.insert(static_cast<Variable*>(parameter)->slot);
+
+        std::string body;
+        const vector<Expression*>& statements = candidate.function->expressionBlock->expressions;
+        bool returned = false;
+        for (size_t i = 0; ok && !returned && i < statements.size(); i++)
+        {
+            Expression* statement = statements[i];
+            bool last = i + 1 == statements.size();
+            switch(statement->getType())
+            {
+                case ex_Assignment:
+                {
+                    Assignment* assignment = static_cast<Assignment*>(statement);
+                    int slot = assignment->identifier->slot;
+                    if (last || assignment->identifier->depth != 0 || defined.count(slot)) return false;
+                    body += "    const double " + slot_name(slot) + " = " + emit(assignment->assignment) + ";\n";
+                    defined.insert(slot);
+                    break;
+                }
+                case ex_ReturnExpression:
+                    body += "    return " + emit(static_cast<ReturnExpression*>(statement)->returnValue) + ";\n";
+                    returned = true;
+                    break;
+                default:
+                {
+                    //Values of the statements before the last one are never used
+                    std::string value = emit(statement);
+                    if (last) body += "    return " + value + ";\n";
+                    returned = last;
+                }
+            }
+        }
+        if (!ok || !returned) return false;
+        candidate.code = signature(index) + "\n{\n" + body + "}\n";
+        return true;
+    }
+
+    //Functions calling one that cannot be compiled cannot be either
+    void select()
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                if (!candidates[i].eligible || emit_function(i)) continue;
+                candidates[i].eligible = false;
+                changed = true;
+            }
+        }
+    }
+
+    //Adds what evaluating the expression makes the tree walker force: both operands, the argument
+    //of a builtin, a local when it is read and the arguments of the parameters a called function forces
+    void force(NativeCandidate& candidate,Expression* expression,std::map<int,Expression*>& locals)
+    {
+        switch(expression->getType())
+        {
+            case ex_Variable:
+            {
+                Variable* variable = static_cast<Variable*>(expression);
+                if (variable->depth == 1) candidate.forcedReads.insert(variable->symbol);
+                if (variable->depth != 0) return;
+                auto local = locals.find(variable->slot);
+                if (local != locals.end())
+                {
+                    //A local is forced once, it keeps its value
+                    Expression* value = local->second;
+                    locals.erase(local);
+                    force(candidate,value,locals);
+                    return;
+                }
+                Vector* parameters = candidate.function->parameterVector;
+                for (size_t i = 0; i < parameters->size(); i++) if (static_cast<Variable*>(parameters->at(i))->slot == variable->slot) candidate.forcedParameters.insert(i);
+                return;
+            }
+            case ex_Vector:
+                force(candidate,static_cast<Vector*>(expression)->at(0),locals);
+                return;
+            case ex_Operation:
+                force(candidate,static_cast<Operation*>(expression)->a,locals);
+                force(candidate,static_cast<Operation*>(expression)->b,locals);
+                return;
+            case ex_FunctionCall:
+            {
+                FunctionCall* call = static_cast<FunctionCall*>(expression);
+                if (call->functionIdentifier->depth == 2)
+                {
+                    force(candidate,call->valueVector->at(0),locals);
+                    return;
+                }
+                NativeCandidate& callee = candidates[bySymbol.at(call->functionIdentifier->symbol)];
+                std::set<size_t> parameters = callee.forcedParameters;
+                std::set<int> reads = callee.forcedReads;
+                for (size_t i : parameters) force(candidate,call->valueVector->at(i),locals);
+                candidate.forcedReads.insert(reads.begin(),reads.end());
+                return;
+            }
+            default: return;
+        }
+    }
+
+    //Statements other than assignments are evaluated even when their value is not used, assignments when they are read
+    void force_body(NativeCandidate& candidate)
+    {
+        std::map<int,Expression*> locals;
+        for (Expression* statement : candidate.function->expressionBlock->expressions)
+        {
+            switch(statement->getType())
+            {
+                case ex_Assignment:
+                {
+                    Assignment* assignment = static_cast<Assignment*>(statement);
+                    locals[assignment->identifier->slot] = assignment->assignment;
+                    break;
+                }
+                case ex_ReturnExpression:
+                    force(candidate,static_cast<ReturnExpression*>(statement)->returnValue,locals);
+                    return;
+                default: force(candidate,statement,locals);
+            }
+        }
+    }
+
+    //Least fixed point, a recursive call forces what the function forces
+    void force_all()
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (NativeCandidate& candidate : candidates)
+            {
+                if (!candidate.eligible) continue;
+                size_t forced = candidate.forcedParameters.size() + candidate.forcedReads.size();
+                force_body(candidate);
+                changed |= candidate.forcedParameters.size() + candidate.forcedReads.size() != forced;
+            }
+        }
+    }
+
+    std::string source()
+    {
+        std::string code = "//";
+        code += native_compiler;
+        for (const char* flag : native_flags) code += std::string(" ") + flag;
+        code += "\n#include <cmath>\n#include <cstddef>\n\n";
+        code += "typedef void (*kernel)(double* out,const double* a,size_t n);\n";
+        code += "static kernel kernels[" + std::to_string(std::max<size_t>(builtins.size(),1)) + "];\n\n";
+        code += "static inline double call(int k,double x) { double y; kernels[k](&y,&x,1); return y; }\n\n";
+        for (size_t i = 0; i < candidates.size(); i++) if (candidates[i].eligible) code += signature(i) + ";\n";
+        for (size_t i = 0; i < candidates.size(); i++) if (candidates[i].eligible) code += "\n" + candidates[i].code;
+        code += "\nextern \"C\" void express_link(const kernel* table) { for (size_t i = 0; i < " + std::to_string(builtins.size()) + "; i++) kernels[i] = table[i]; }\n";
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (!candidates[i].eligible) continue;
+            code += "extern \"C\" double express_function_" + std::to_string(i) + "(const double* a,const double* g) { return f" + std::to_string(i) + "(g";
+            for (size_t j = 0; j < candidates[i].function->parameterVector->size(); j++) code += ",a[" + std::to_string(j) + "]";
+            code += "); }\n";
+        }
+        return code;
+    }
+};
+
+static bool write_file(const std::string& path,const std::string& text)
+{
+    FILE* file = std::fopen(path.c_str(),"w");
+    if (file == nullptr) return false;
+    bool written = std::fwrite(text.data(),1,text.size(),file) == text.size();
+    return std::fclose(file) == 0 && written;
+}
+
+static bool run_compiler(const std::string& source,const std::string& object)
+{
+    std::vector<std::string> arguments = { native_compiler };
+    for (const char* flag : native_flags) arguments.push_back(flag);
+    arguments.insert(arguments.end(),{ "-o", object, source });
+    std::vector<char*> argv;
+    for (std::string& argument : arguments) argv.push_back(&argument[0]);
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (::posix_spawnp(&pid,native_compiler,nullptr,nullptr,argv.data(),environ) != 0) return false;
+    int status;
+    while (::waitpid(pid,&status,0) < 0) if (errno != EINTR) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//The shared object of the source, compiled aside and renamed when it is not in the directory yet
+static std::string native_object(const std::string& directory,const std::string& code)
+{
+    uint64_t hash = content_hash(code.data(),code.size());
+    char name[32];
+    std::snprintf(name,sizeof(name),"/%016llx",static_cast<unsigned long long>(hash));
+    std::string path = directory + name + ".so";
+    if (::access(path.c_str(),R_OK) == 0) return path;
+
+    ::mkdir(directory.c_str(),0755);
+    std::string temporary = directory + name + "." + std::to_string(::getpid());
+    bool compiled = write_file(temporary + ".cc",code) && run_compiler(temporary + ".cc",temporary + ".so");
+    ::unlink((temporary + ".cc").c_str());
+    if (!compiled || std::rename((temporary + ".so").c_str(),path.c_str()) != 0)
+    {
+        ::unlink((temporary + ".so").c_str());
+        return std::string();
+    }
+    return path;
+}
+
+NativeModule* compile_native(Expression* root,Scope& scope)
+{
+    if (root->getType() != ex_ExpressionBlock) return nullptr;
+    NativeCompiler compiler(scope,static_cast<ExpressionBlock*>(root));
+    compiler.select();
+    compiler.force_all();
+    size_t eligible = std::count_if(compiler.candidates.begin(),compiler.candidates.end(),[](const NativeCandidate& c) { return c.eligible; });
+    if (eligible == 0 || compiler.globals.size() > native_max_globals) return nullptr;
+
+    std::string path = native_object(scope.nativeDirectory,compiler.source());
+    if (path.empty()) return nullptr;
+    void* handle = ::dlopen(path.c_str(),RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) return nullptr;
+
+    NativeModule* module = new NativeModule();
+    module->handle = handle;
+    nativeLink link = reinterpret_cast<nativeLink>(::dlsym(handle,"express_link"));
+    std::vector<MathKernels::mapKernel> kernels;
+    for (InternalFunction* builtin : compiler.builtins) kernels.push_back(builtin->functionPtr.batchFunction);
+    if (link == nullptr)
+    {
+        delete module;
+        return nullptr;
+    }
+    link(kernels.data());
+
+    module->functions.reserve(eligible);
+    for (size_t i = 0; i < compiler.candidates.size(); i++)
+    {
+        NativeCandidate& candidate = compiler.candidates[i];
+        if (!candidate.eligible) continue;
+        NativeFunction native;
+        native.entry = reinterpret_cast<nativeEntry>(::dlsym(handle,("express_function_" + std::to_string(i)).c_str()));
+        if (native.entry == nullptr) continue;
+        native.parameters = candidate.function->parameterVector->size();
+        native.forced.resize(native.parameters);
+        for (size_t parameter : candidate.forcedParameters) native.forced[parameter] = true;
+        for (int symbol : candidate.forcedReads) native.globals.emplace_back(compiler.globals[symbol],compiler.globalLayout.at(symbol));
+        module->functions.push_back(native);
+        candidate.function->native = &module->functions.back();
+    }
+    return module;
+}
+
+void release_native_module(NativeModule* module)
+{
+    delete module;
+}
+
+//Arguments whose shape the parser already tells are not a number
+static bool never_numeric(Expression* argument)
+{
+    switch(argument->getType())
+    {
+        case ex_StringConstant: return true;
+        case ex_Constant: return !static_cast<Constant*>(argument)->v.is_numeric();
+        case ex_Vector: return static_cast<Vector*>(argument)->size() != 1;
+        default: return false;
+    }
+}
+
+//The numbers already evaluated go back as values, the tree walker binds them instead of evaluating the arguments again
+static bool fall_back(NativeFunction* function,const double* numbers,size_t count,Value* last,std::vector<Value>& values,std::vector<bool>& evaluated)
+{
+    values.resize(function->parameters);
+    evaluated.resize(function->parameters);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!function->forced[i]) continue;
+        values[i] = Value(numbers[i]);
+        evaluated[i] = true;
+    }
+    if (last)
+    {
+        values[count] = std::move(*last);
+        evaluated[count] = true;
+    }
+    return false;
+}
+
+bool native_evaluate(Scope& scope,NativeFunction* function,Vector* arguments,Value& result,std::vector<Value>& values,std::vector<bool>& evaluated)
+{
+    if (arguments->size() != function->parameters) return false;
+    for (size_t i = 0; i < function->parameters; i++) if (function->forced[i] && never_numeric(arguments->at(i))) return false;
+
+    //The arguments and names the result does not depend on are not evaluated, the body reads zeros for them
+    double numbers[native_max_parameters] = {};
+    double globals[native_max_globals] = {};
+    for (size_t i = 0; i < function->parameters; i++)
+    {
+        if (!function->forced[i]) continue;
+        Value v = arguments->at(i)->evaluate(scope);
+        if (!v.is_numeric()) return fall_back(function,numbers,i,&v,values,evaluated);
+        numbers[i] = v[0];
+    }
+    //Document level names are read when the function is called, rebinding them is seen
+    for (const std::pair<int,int>& global : function->globals)
+    {
+        Binding* binding = &scope.global->slots[global.second];
+        if (binding->expression == nullptr) return fall_back(function,numbers,function->parameters,nullptr,values,evaluated);
+        Value v = Variable::force(scope,binding);
+        if (!v.is_numeric()) return fall_back(function,numbers,function->parameters,nullptr,values,evaluated);
+        globals[global.first] = v[0];
+    }
+    result = function->entry(numbers,globals);
+    return true;
+}
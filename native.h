@@ -0,0 +1,32 @@
+#pragma once
+#include "value.h"
+#include <vector>
+
+struct Expression;
+struct Vector;
+struct Scope;
+struct NativeModule;
+struct NativeFunction;
+
+/*
+    Native code for document level pure functions whose body is numeric: parameters,
+    local assignments, number constants, + - * / ^, scalar builtins with a batch kernel
+    and calls to other such functions. Their C++ is generated into one translation unit
+    per document, compiled by g++ into a shared object and loaded with dlopen.
+    The object is kept in the directory of EXPRESS_NATIVE=<directory> under the hash of its
+    source, a document whose functions did not change loads it again without compiling.
+    Arithmetic is done as Value does it and builtins call the same kernels, so a native call
+    returns exactly what the tree walker would. Calls with an argument or a document level
+    name that is not a number, and every function when g++ is missing, use the tree walker.
+    Only the arguments and names the result depends on are evaluated, the ones the tree walker
+    would not force stay unevaluated, and the ones evaluated before falling back are handed
+    to the tree walker so they are not evaluated twice.
+*/
+
+//Compiles the functions of the document, nullptr when none of them can be
+NativeModule* compile_native(Expression* root,Scope& scope);
+void release_native_module(NativeModule* module);
+
+//Calls the compiled body with the evaluated arguments, false when it cannot take them.
+//The arguments evaluated on the way are then in values, marked in evaluated, see Function::evaluate_bound()
+bool native_evaluate(Scope& scope,NativeFunction* function,Vector* arguments,Value& result,std::vector<Value>& values,std::vector<bool>& evaluated);
@@ -0,0 +1,230 @@
+#include "optimizer.h"
+#include "expression_types.h"
+#include <unordered_map>
+
+struct Optimizer
+{
+    Scope& scope;
+    std::vector<const Layout*> chain;   //Innermost block last
+
+    //Structural key of every candidate subexpression and how many times it appears per block
+    std::unordered_map<Expression*,std::string> keys;
+    std::map<const Layout*,std::map<std::string,int>> counts;
+    std::map<const Layout*,std::map<std::string,int>> classes;
+
+    Optimizer(Scope& _scope) : scope(_scope) { }
+
+    Expression* builtin(Variable* variable)
+    {
+        if (variable->slot < 0 || variable->depth != (int)chain.size()) return nullptr;
+        return scope.builtins.slots[variable->slot].expression;
+    }
+
+    bool is_builtin_call(FunctionCall* call)
+    {
+        Expression* function = builtin(call->functionIdentifier);
+        return function && function->getType() == ex_InternalFunction && !static_cast<InternalFunction*>(function)->is_expression_function();
+    }
+
+    //Marks the folded nodes, returns true when the subtree is constant
+    bool fold(Expression* expression)
+    {
+        bool constant = true;
+        switch(expression->getType())
+        {
+            case ex_Constant: return true;
+            case ex_Variable:
+            {
+                Expression* value = builtin(static_cast<Variable*>(expression));
+                return value && value->getType() == ex_Constant;
+            }
+            case ex_Vector:
+                for (Expression* e : static_cast<Vector*>(expression)->variables) constant &= fold(e);
+                break;
+            case ex_Operation:
+                constant &= fold(static_cast<Operation*>(expression)->a);
+                constant &= fold(static_cast<Operation*>(expression)->b);
+                break;
+            case ex_FunctionCall:
+            {
+                FunctionCall* call = static_cast<FunctionCall*>(expression);
+                constant &= fold(call->valueVector) && is_builtin_call(call);
+                break;
+            }
+            case ex_Assignment:
+                fold(static_cast<Assignment*>(expression)->assignment);
+                return false;
+            case ex_ReturnExpression:
+                fold(static_cast<ReturnExpression*>(expression)->returnValue);
+                return false;
+            case ex_ExpressionBlock:
+                chain.push_back(&static_cast<ExpressionBlock*>(expression)->layout);
+                for (Expression* e : static_cast<ExpressionBlock*>(expression)->expressions) fold(e);
+                chain.pop_back();
+                return false;
+            case ex_Function:
+                fold(static_cast<Function*>(expression)->expressionBlock);
+                return false;
+            default: return false;
+        }
+        expression->is_folded = constant;
+        return constant;
+    }
+
+    //Builds the structural key of a subtree, empty when it can not be shared
+    std::string key(Expression* expression)
+    {
+        std::string k;
+        switch(expression->getType())
+        {
+            case ex_Constant:
+            {
+                const Value& v = static_cast<Constant*>(expression)->v;
+                if (v.get_kind() == val_string) return "";
+                k = "c";
+                for (double d : v)
+                {
+                    uint64_t bits;
+                    std::memcpy(&bits,&d,sizeof(bits));
+                    k += std::to_string(bits) + ",";
+                }
+                return k;
+            }
+            case ex_Variable:
+            {
+                Variable* variable = static_cast<Variable*>(expression);
+                return "v" + std::to_string(variable->symbol) + ":" + std::to_string(variable->depth) + ":" + std::to_string(variable->slot);
+            }
+            case ex_Vector:
+                k = "(";
+                for (Expression* e : static_cast<Vector*>(expression)->variables)
+                {
+                    std::string element = key(e);
+                    if (element.empty()) return "";
+                    k += element + ",";
+                }
+                return k + ")";
+            case ex_Operation:
+            {
+                Operation* operation = static_cast<Operation*>(expression);
+                std::string a = key(operation->a), b = key(operation->b);
+                if (a.empty() || b.empty()) return "";
+                return std::string(OperationTypeLiterals[operation->op_type]) + "(" + a + "," + b + ")";
+            }
+            case ex_FunctionCall:
+            {
+                FunctionCall* call = static_cast<FunctionCall*>(expression);
+                if (!is_builtin_call(call)) return "";
+                std::string arguments = key(call->valueVector);
+                if (arguments.empty()) return "";
+                return "f" + std::to_string(call->functionIdentifier->symbol) + arguments;
+            }
+            default: return "";
+        }
+    }
+
+    static bool is_candidate(Expression* expression)
+    {
+        switch(expression->getType())
+        {
+            case ex_Vector:
+            case ex_Operation:
+            case ex_FunctionCall: return !expression->is_folded;
+            default: return false;
+        }
+    }
+
+    //Visits the subexpressions evaluated in the frame of the innermost block
+    template <typename Visitor>
+    void walk(Expression* expression,Visitor visit)
+    {
+        switch(expression->getType())
+        {
+            case ex_Vector:
+                if (!visit(expression)) return;
+                for (Expression* e : static_cast<Vector*>(expression)->variables) walk(e,visit);
+                break;
+            case ex_Operation:
+                if (!visit(expression)) return;
+                walk(static_cast<Operation*>(expression)->a,visit);
+                walk(static_cast<Operation*>(expression)->b,visit);
+                break;
+            case ex_FunctionCall:
+                if (!visit(expression)) return;
+                walk(static_cast<FunctionCall*>(expression)->valueVector,visit);
+                break;
+            case ex_Assignment:
+                walk(static_cast<Assignment*>(expression)->assignment,visit);
+                break;
+            case ex_ReturnExpression:
+                walk(static_cast<ReturnExpression*>(expression)->returnValue,visit);
+                break;
+            case ex_ExpressionBlock:
+                chain.push_back(&static_cast<ExpressionBlock*>(expression)->layout);
+                for (Expression* e : static_cast<ExpressionBlock*>(expression)->expressions) walk(e,visit);
+                chain.pop_back();
+                break;
+            case ex_Function:
+                walk(static_cast<Function*>(expression)->expressionBlock,visit);
+                break;
+            default: break;
+        }
+    }
+
+    void count(Expression* root)
+    {
+        walk(root,[&](Expression* expression)
+        {
+            if (!is_candidate(expression)) return true;
+            std::string k = key(expression);
+            if (!k.empty())
+            {
+                keys[expression] = k;
+                counts[chain.back()][k]++;
+            }
+            return true;
+        });
+    }
+
+    //Only the outermost repeated subexpressions are numbered, the inner ones are evaluated once anyway
+    void number(Expression* root)
+    {
+        walk(root,[&](Expression* expression)
+        {
+            auto it = keys.find(expression);
+            if (it == keys.end() || counts[chain.back()][it->second] < 2) return true;
+            auto& blockClasses = classes[chain.back()];
+            auto found = blockClasses.find(it->second);
+            int index = found != blockClasses.end() ? found->second : (blockClasses[it->second] = blockClasses.size());
+            expression->common = index;
+            expression->commonLayout = chain.back();
+            return false;
+        });
+    }
+};
+
+void optimize_program(Expression* root,const Layout* layout,Scope& scope)
+{
+    Optimizer optimizer(scope);
+    //A document block pushes its own layout, otherwise the root lives in the global frame
+    if (root->getType() != ex_ExpressionBlock) optimizer.chain.push_back(layout);
+    optimizer.fold(root);
+    optimizer.count(root);
+    optimizer.number(root);
+}
+
+Value Expression::evaluate_common(Scope& scope)
+{
+    Frame* frame = scope.current;
+    wasEvaluated = true;
+    if (!scope.eliminateCommon || frame->layout != commonLayout) return lastEvaluatedValue = i_evaluate(scope);
+
+    if (frame->common.size() <= (size_t)common) frame->common.resize(common + 1);
+    if (frame->common[common].epoch == scope.epoch) return lastEvaluatedValue = frame->common[common].value;
+
+    //Anything assigning while this is evaluated may change the value, it is not stored then
+    unsigned epoch = scope.epoch;
+    lastEvaluatedValue = i_evaluate(scope);
+    if (scope.epoch == epoch) frame->common[common] = {lastEvaluatedValue,epoch};
+    return lastEvaluatedValue;
+}
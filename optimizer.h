@@ -0,0 +1,13 @@
+#pragma once
+#include "scope.h"
+
+/*
+    Optimization pass run after the resolver, it never changes the shape of the tree so
+    printing is not affected.
+    Constant subtrees (numbers, vectors, builtin constants and builtin calls over them)
+    are marked folded: they are evaluated once and their value is reused from then on.
+    Structurally identical subexpressions of a block are numbered as one common
+    subexpression, the first one evaluated in an activation of the block stores its
+    value in the Frame and the others reuse it until the next assignment.
+*/
+void optimize_program(Expression* root,const Layout* layout,Scope& scope);
@@ -0,0 +1,70 @@
+#pragma once
+#include "value.h"
+#include <functional>
+#include <unistd.h>
+#include <cerrno>
+
+/*
+    Buffered writer the printer emits into. Text is gathered in a fixed buffer and handed
+    to the target when it fills up or on flush(): a std::string, a file descriptor or a
+    callback. Numbers are formatted in place, printing never builds temporary strings.
+*/
+struct OutputSink
+{
+    using Callback = std::function<void(const char*,size_t)>;
+
+    static const size_t buffer_size = 8192;
+
+    OutputSink(std::string& _target) : target(&_target) { }
+    OutputSink(int _fd) : fd(_fd) { }
+    OutputSink(Callback _callback) : callback(std::move(_callback)) { }
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    ~OutputSink() { flush(); }
+
+    void append(const char* data,size_t size)
+    {
+        if (used + size > buffer_size)
+        {
+            flush();
+            if (size > buffer_size) { emit(data,size); return; }
+        }
+        std::memcpy(buffer + used,data,size);
+        used += size;
+    }
+
+    OutputSink& operator+=(const char* text) { append(text,std::strlen(text)); return *this; }
+    OutputSink& operator+=(const std::string& text) { append(text.data(),text.size()); return *this; }
+    OutputSink& operator+=(char c) { append(&c,1); return *this; }
+    OutputSink& operator+=(const Value& value) { value.format(*this); return *this; }
+
+    void flush()
+    {
+        if (used == 0) return;
+        size_t size = used;
+        used = 0;
+        emit(buffer,size);
+    }
+
+    private:
+
+    void emit(const char* data,size_t size)
+    {
+        if (target) { target->append(data,size); return; }
+        if (callback) { callback(data,size); return; }
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd,data,size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return;           //Nothing sensible to do when the output is gone
+            data += written;
+            size -= written;
+        }
+    }
+
+    std::string* target = nullptr;
+    int fd = -1;
+    Callback callback;
+    size_t used = 0;
+    char buffer[buffer_size];
+};
@@ -0,0 +1,267 @@
+#include "parallel.h"
+#include "expression_types.h"
+#include "scheduler.h"
+#include <exception>
+
+static const double scalar_call_cost = 16;     //Relative cost of a builtin or a power per element
+
+struct Inspection
+{
+    bool safe = true;                   //Can run on another thread once every name read is forced
+    bool assigns = false;               //Changes a binding, nothing around it may be reordered
+    double cost = 0;
+    std::vector<Binding*> reads;
+};
+
+//Walks what evaluating the expression would do without evaluating anything, returns the size of the result
+static size_t inspect(Scope& scope,Expression* expression,Inspection& out)
+{
+    if (expression->is_folded && expression->wasEvaluated) return expression->lastEvaluatedValue.size();
+
+    switch(expression->getType())
+    {
+        case ex_Constant: return static_cast<Constant*>(expression)->v.size();
+        case ex_Function: return 0;
+        case ex_Variable:
+        {
+            Binding* binding = scope.find_binding(static_cast<Variable*>(expression));
+            if (binding == nullptr) { out.safe = false; return 1; }
+            out.reads.push_back(binding);
+            size_t size = binding->epoch == scope.epoch ? binding->value.size() : 1;
+            out.cost += size;
+            return size;
+        }
+        case ex_Vector:
+        {
+            Vector* vector = static_cast<Vector*>(expression);
+            if (vector->size() == 1) return inspect(scope,vector->at(0),out);
+            for (Expression* e : vector->variables) inspect(scope,e,out);
+            out.cost += vector->size();
+            return vector->size();
+        }
+        case ex_Operation:
+        {
+            Operation* operation = static_cast<Operation*>(expression);
+            if (operation->op_type == op_ref)
+            {
+                inspect(scope,operation->b,out);
+                //An indexed vector that was not forced only evaluates one element, it stays lazy
+                if (operation->a->getType() == ex_Variable)
+                {
+                    Binding* binding = scope.find_binding(static_cast<Variable*>(operation->a));
+                    if (binding == nullptr || (binding->epoch != scope.epoch && binding->expression->getType() == ex_Vector))
+                    {
+                        out.safe = false;
+                        return 1;
+                    }
+                }
+                inspect(scope,operation->a,out);
+                out.cost += 1;
+                return 1;
+            }
+            size_t size = std::max(inspect(scope,operation->a,out),inspect(scope,operation->b,out));
+            out.cost += operation->op_type == op_exp ? size * scalar_call_cost : size;
+            return size;
+        }
+        case ex_FunctionCall:
+        {
+            FunctionCall* call = static_cast<FunctionCall*>(expression);
+            Binding* binding = scope.find_binding(call->functionIdentifier);
+            if (call->is_mutated || binding == nullptr || binding->expression->getType() != ex_InternalFunction)
+            {
+                out.safe = false;
+                return 1;
+            }
+            InternalFunction* function = static_cast<InternalFunction*>(binding->expression);
+            if (function->is_expression_function()) { out.safe = false; return 1; }
+            size_t size = inspect(scope,call->valueVector->at(0),out);
+            if (function->functionPtr.type == fn_vector) { out.cost += size; return 1; }
+            out.cost += size * scalar_call_cost;
+            return size;
+        }
+        case ex_Assignment:
+            out.assigns = true;
+            out.safe = false;
+            return 1;
+        default:
+            out.safe = false;
+            return 1;
+    }
+}
+
+static bool ready(Scope& scope,const Inspection& inspection)
+{
+    if (!inspection.safe) return false;
+    for (Binding* binding : inspection.reads) if (binding->epoch != scope.epoch) return false;
+    return true;
+}
+
+//Shared by every Scope, documents evaluated at the same time do not each start a pool
+static TaskScheduler& scheduler(Scope& scope)
+{
+    return TaskScheduler::shared(scope.threads);
+}
+
+//Runs every job on the scheduler, common subexpressions are not shared meanwhile as that writes the Frame
+static void run(Scope& scope,std::vector<TaskScheduler::Task>& tasks)
+{
+    bool eliminateCommon = scope.eliminateCommon;
+    scope.eliminateCommon = false;
+    scheduler(scope).run(tasks);
+    scope.eliminateCommon = eliminateCommon;
+}
+
+bool parallel_evaluate(Scope& scope,Vector* vector,Value& result)
+{
+    if (scope.threads < 2 || TaskScheduler::in_task()) return false;
+
+    //Vectors of numbers and names are by far the most common, they are never worth it
+    size_t candidates = 0;
+    for (Expression* e : vector->variables)
+    {
+        ExpressionType type = e->getType();
+        if (type == ex_Operation || type == ex_FunctionCall) candidates++;
+    }
+    if (candidates < 2) return false;
+
+    size_t n = vector->size();
+    std::vector<Inspection> inspections(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        inspect(scope,vector->at(i),inspections[i]);
+        if (inspections[i].assigns) return false;
+    }
+
+    //Names are forced up front in order, an error is left for the evaluation in order to report
+    for (Inspection& inspection : inspections)
+    {
+        if (!inspection.safe) continue;
+        for (Binding* binding : inspection.reads)
+        {
+            if (binding->epoch == scope.epoch) continue;
+            try { Variable::force(scope,binding); }
+            catch (...) { }
+        }
+    }
+
+    std::vector<size_t> heavy;
+    for (size_t i = 0; i < n; i++)
+    {
+        Inspection inspection;
+        inspect(scope,vector->at(i),inspection);
+        if (ready(scope,inspection) && inspection.cost >= scope.parallelCost) heavy.push_back(i);
+    }
+    if (heavy.size() < 2) return false;
+
+    std::vector<double> values(n);
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<TaskScheduler::Task> tasks;
+    for (size_t i : heavy)
+    {
+        tasks.push_back([&scope,&values,&errors,vector,i]
+        {
+            try { values[i] = vector->at(i)->evaluate(scope)[0]; }
+            catch (...) { errors[i] = std::current_exception(); }
+        });
+    }
+    run(scope,tasks);
+
+    //The rest in order, so the first error is the one a sequential evaluation reports
+    size_t next = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (next < heavy.size() && heavy[next] == i)
+        {
+            next++;
+            if (errors[i]) std::rethrow_exception(errors[i]);
+            continue;
+        }
+        values[i] = vector->at(i)->evaluate(scope)[0];
+    }
+    result = Value(values);
+    return true;
+}
+
+struct Thunk
+{
+    Binding* binding;
+    bool done = false;
+};
+
+//Adds the thunks of the current block the reads lead to, and the ones those need in turn
+static void demand(Scope& scope,const std::vector<Binding*>& reads,std::vector<Thunk>& thunks)
+{
+    for (Binding* binding : reads)
+    {
+        if (binding->frame != scope.current || binding->epoch == scope.epoch) continue;
+        bool known = false;
+        for (const Thunk& thunk : thunks) known |= thunk.binding == binding;
+        if (known) continue;
+
+        thunks.push_back({binding});
+        Inspection inspection;
+        inspect(scope,binding->expression,inspection);
+        if (!inspection.assigns) demand(scope,inspection.reads,thunks);
+    }
+}
+
+void parallel_force(Scope& scope,Expression* statement)
+{
+    if (scope.threads < 2 || TaskScheduler::in_task()) return;
+
+    Inspection inspection;
+    inspect(scope,statement,inspection);
+    if (inspection.assigns) return;
+    std::vector<Thunk> thunks;
+    demand(scope,inspection.reads,thunks);
+    if (thunks.size() < 2) return;
+
+    //In waves: whatever is ready is forced, cheap thunks right away and heavy ones in parallel
+    for (;;)
+    {
+        bool progress = false;
+        std::vector<Thunk*> heavy;
+        for (Thunk& thunk : thunks)
+        {
+            if (thunk.done) continue;
+            Inspection inspection;
+            inspect(scope,thunk.binding->expression,inspection);
+            if (!ready(scope,inspection)) continue;
+            if (inspection.cost >= scope.parallelCost) { heavy.push_back(&thunk); continue; }
+            //Errors are left to the lazy evaluation, it reports them if the value is really used
+            try { Variable::force(scope,thunk.binding); }
+            catch (...) { }
+            thunk.done = progress = true;
+        }
+        if (heavy.empty() && !progress) break;
+        if (heavy.size() == 1)
+        {
+            try { Variable::force(scope,heavy[0]->binding); }
+            catch (...) { }
+            heavy[0]->done = true;
+            continue;
+        }
+
+        unsigned epoch = scope.epoch;
+        std::vector<Value> values(heavy.size());
+        std::vector<char> failed(heavy.size(),false);
+        std::vector<TaskScheduler::Task> tasks;
+        for (size_t i = 0; i < heavy.size(); i++)
+        {
+            Binding* binding = heavy[i]->binding;
+            tasks.push_back([&scope,&values,&failed,binding,i]
+            {
+                try { values[i] = binding->expression->evaluate(scope); }
+                catch (...) { failed[i] = true; }
+            });
+        }
+        run(scope,tasks);
+        for (size_t i = 0; i < heavy.size(); i++)
+        {
+            heavy[i]->done = true;
+            if (failed[i] || values[i].is_string()) continue;
+            heavy[i]->binding->value = std::move(values[i]);
+            heavy[i]->binding->epoch = epoch;
+        }
+    }
+}
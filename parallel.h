@@ -0,0 +1,21 @@
+#pragma once
+#include "value.h"
+
+struct Scope;
+struct Expression;
+struct Vector;
+
+/*
+    Parallel evaluation on the work stealing TaskScheduler of the process, see scheduler.h.
+    Only work that leaves the Scope untouched is handed to other threads: arithmetic,
+    vectors, indexing and builtin calls over names whose thunks are already forced.
+    Assignments, user function calls and strings are always evaluated in order on the
+    calling thread. Work is handed out once its estimated cost, roughly the number of
+    element operations, crosses Scope::parallelCost and there are at least two such pieces.
+*/
+
+//Evaluates the components of a vector in parallel, false when it is not worth it
+bool parallel_evaluate(Scope& scope,Vector* vector,Value& result);
+
+//Forces the thunks of the current block that the statement is going to read, independent ones in parallel
+void parallel_force(Scope& scope,Expression* statement);
@@ -0,0 +1,264 @@
+#include "profile.h"
+#include "expression_types.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <unordered_set>
+
+using profileClock = std::chrono::steady_clock;
+
+static uint64_t nanoseconds(profileClock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+struct ProfileStats
+{
+    uint64_t calls = 0;
+    uint64_t inclusive = 0;             //Nanoseconds
+    uint64_t exclusive = 0;
+    uint64_t bytes = 0;                 //Allocated by the node itself
+    unsigned active = 0;                //Calls in progress, only the outermost adds its inclusive time
+};
+
+struct Profiler
+{
+    //A node being evaluated
+    struct Entry
+    {
+        Expression* node;
+        Function* function;             //User function the node calls, if any
+        bool statement;                 //Started the frame of its line
+        profileClock::time_point start;
+        size_t startBytes;
+        uint64_t childTime = 0;
+        size_t childBytes = 0;
+    };
+
+    unsigned threads;                   //Of the scope before profiling
+    const Symbols* symbols;
+    std::string document;
+    std::unordered_set<const Expression*> statements;
+    std::unordered_map<Expression*,ProfileStats> nodes;
+    std::unordered_map<Function*,ProfileStats> functions;
+    std::vector<Entry> stack;
+    std::vector<uint64_t> calleeTime;   //Per user function being evaluated, spent in the user functions it called
+
+    //Path of frames joined by ';', charged with the time since mark when it changes
+    std::string path;
+    std::vector<size_t> pathLengths;
+    std::unordered_map<std::string,uint64_t> folded;
+    profileClock::time_point mark;
+
+    void charge(profileClock::time_point now)
+    {
+        uint64_t elapsed = nanoseconds(now - mark);
+        if (elapsed) folded[path] += elapsed;
+        mark = now;
+    }
+
+    void push_frame(const std::string& name,profileClock::time_point now)
+    {
+        charge(now);
+        pathLengths.push_back(path.size());
+        path += ';';
+        path += name;
+    }
+
+    void pop_frame(profileClock::time_point now)
+    {
+        charge(now);
+        path.resize(pathLengths.back());
+        pathLengths.pop_back();
+    }
+
+    void enter(Expression* node,Function* function)
+    {
+        profileClock::time_point now = profileClock::now();
+        //An assignment evaluating its own value stays in the frame of its line
+        bool statement = false;
+        if (statements.count(node))
+        {
+            std::string frame = "line " + std::to_string(node->span.line);
+            statement = path.size() < frame.size() || path.compare(path.size() - frame.size(),frame.size(),frame) != 0;
+            if (statement) push_frame(frame,now);
+        }
+        if (function)
+        {
+            push_frame(function_name(function),now);
+            calleeTime.push_back(0);
+            ProfileStats& stats = functions[function];
+            stats.calls++;
+            stats.active++;
+        }
+        ProfileStats& stats = nodes[node];
+        stats.calls++;
+        stats.active++;
+        stack.push_back({node,function,statement,profileClock::now(),valueAllocatedBytes});
+    }
+
+    void leave()
+    {
+        profileClock::time_point now = profileClock::now();
+        Entry entry = stack.back();
+        stack.pop_back();
+
+        uint64_t inclusive = nanoseconds(now - entry.start);
+        size_t bytes = valueAllocatedBytes - entry.startBytes;
+        ProfileStats& stats = nodes[entry.node];
+        if (--stats.active == 0) stats.inclusive += inclusive;
+        stats.exclusive += inclusive - std::min(inclusive,entry.childTime);
+        stats.bytes += bytes - std::min(bytes,entry.childBytes);
+        if (!stack.empty())
+        {
+            stack.back().childTime += inclusive;
+            stack.back().childBytes += bytes;
+        }
+
+        if (entry.function)
+        {
+            ProfileStats& calls = functions[entry.function];
+            if (--calls.active == 0) calls.inclusive += inclusive;
+            calls.exclusive += inclusive - std::min(inclusive,calleeTime.back());
+            calls.bytes += bytes;
+            calleeTime.pop_back();
+            if (!calleeTime.empty()) calleeTime.back() += inclusive;
+            pop_frame(now);
+        }
+        if (entry.statement) pop_frame(now);
+    }
+
+    std::string function_name(Function* function) const
+    {
+        return function->symbol >= 0 ? symbols->name(function->symbol) : "<anonymous>";
+    }
+};
+
+//Leaves the node also when its evaluation throws
+struct ProfileGuard
+{
+    Profiler* profiler;
+    ~ProfileGuard() { profiler->leave(); }
+};
+
+Value Expression::profiled_evaluate(Scope& scope)
+{
+    Function* function = nullptr;
+    if (getType() == ex_FunctionCall)
+    {
+        FunctionCall* call = static_cast<FunctionCall*>(this);
+        Binding* binding = call->is_mutated ? nullptr : scope.lookup(call->functionIdentifier);
+        if (binding && binding->expression && binding->expression->getType() == ex_Function) function = static_cast<Function*>(binding->expression);
+    }
+    Profiler* profiler = scope.profiler;
+    profiler->enter(this,function);
+    ProfileGuard guard{profiler};
+    return evaluate_node(scope);
+}
+
+Profiler* start_profile(Scope& scope)
+{
+    Profiler* profiler = new Profiler;
+    profiler->threads = scope.threads;
+    profiler->symbols = &scope.symbols;
+    profiler->document = scope.sourceName.empty() ? "<input>" : scope.sourceName;
+    if (Expression* root = scope.rootExpression)
+    {
+        std::vector<Expression*> statements{root};
+        if (root->getType() == ex_ExpressionBlock) statements = root->dependencies;
+        //Assigned values are evaluated when a name is first read, that starts their line too
+        for (Expression* e : statements)
+        {
+            profiler->statements.insert(e);
+            if (e->getType() == ex_Assignment) profiler->statements.insert(static_cast<Assignment*>(e)->assignment);
+        }
+    }
+    profiler->path = profiler->document;
+    profiler->mark = profileClock::now();
+    scope.threads = 1;
+    scope.profiler = profiler;
+    return profiler;
+}
+
+void finish_profile(Scope& scope,Profiler* profiler)
+{
+    profiler->charge(profileClock::now());
+    scope.threads = profiler->threads;
+    scope.profiler = nullptr;
+}
+
+void release_profiler(Profiler* profiler)
+{
+    delete profiler;
+}
+
+template <typename Key>
+static std::vector<std::pair<Key,ProfileStats>> by_exclusive_time(const std::unordered_map<Key,ProfileStats>& stats,size_t limit)
+{
+    std::vector<std::pair<Key,ProfileStats>> rows(stats.begin(),stats.end());
+    std::sort(rows.begin(),rows.end(),[](const auto& a,const auto& b)
+    {
+        return a.second.exclusive != b.second.exclusive ? a.second.exclusive > b.second.exclusive : a.second.calls > b.second.calls;
+    });
+    if (rows.size() > limit) rows.resize(limit);
+    return rows;
+}
+
+static std::string location(const Profiler* profiler,const SourceSpan& span)
+{
+    if (span.line == 0) return profiler->document;
+    return profiler->document + ":" + std::to_string(span.line) + ":" + std::to_string(span.column);
+}
+
+static std::string describe(Expression* node)
+{
+    switch(node->getType())
+    {
+        case ex_Variable: return "Variable " + static_cast<Variable*>(node)->name;
+        case ex_FunctionCall: return "FunctionCall " + static_cast<FunctionCall*>(node)->functionIdentifier->name;
+        case ex_Operation: return std::string("Operation ") + (operationLiteral(node) + 3);
+        default: return literalType(node) + 3;
+    }
+}
+
+static void write_row(OutputSink& out,const std::string& where,const std::string& what,const ProfileStats& stats)
+{
+    char numbers[128];
+    std::snprintf(numbers,sizeof(numbers)," %10llu %12.3f %12.3f %12llu\n",
+        (unsigned long long)stats.calls,stats.inclusive / 1e6,stats.exclusive / 1e6,(unsigned long long)stats.bytes);
+    char text[96];
+    std::snprintf(text,sizeof(text),"%-32.32s %-28.28s",where.c_str(),what.c_str());
+    out += text;
+    out += numbers;
+}
+
+static void write_header(OutputSink& out,const char* what)
+{
+    char text[160];
+    std::snprintf(text,sizeof(text),"%-32s %-28s %10s %12s %12s %12s\n","location",what,"calls","incl ms","excl ms","bytes");
+    out += text;
+}
+
+void write_profile(Profiler* profiler,OutputSink& out,size_t limit)
+{
+    write_header(out,"node");
+    for (auto& row : by_exclusive_time(profiler->nodes,limit)) write_row(out,location(profiler,row.first->span),describe(row.first),row.second);
+    out += '\n';
+    //The exclusive time of a function leaves out the user functions it calls, its bytes include them
+    write_header(out,"function");
+    for (auto& row : by_exclusive_time(profiler->functions,limit)) write_row(out,location(profiler,row.first->span),profiler->function_name(row.first),row.second);
+}
+
+void write_folded_stacks(Profiler* profiler,OutputSink& out)
+{
+    std::vector<std::pair<std::string,uint64_t>> lines(profiler->folded.begin(),profiler->folded.end());
+    std::sort(lines.begin(),lines.end());
+    for (auto& line : lines)
+    {
+        out += line.first;
+        out += ' ';
+        out += std::to_string(line.second);
+        out += '\n';
+    }
+}
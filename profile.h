@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+struct Scope;
+struct Profiler;
+struct OutputSink;
+
+/*
+    Profile of a tree walker evaluation, attributed to the source the nodes were parsed from.
+    While a profiler is attached every Expression::evaluate() of the document is timed: calls,
+    inclusive and exclusive time and the bytes values allocated, per node and per user function.
+    Recursive calls add their inclusive time once, at the outermost call.
+    Evaluation is sequential while profiling, parallel work would be timed on other threads.
+    The folded stacks have one line per path of document, top level statement and function
+    calls, with the exclusive nanoseconds spent there, the format flamegraph.pl reads.
+*/
+
+Profiler* start_profile(Scope& scope);
+//Detaches the profiler, the reports can be written afterwards
+void finish_profile(Scope& scope,Profiler* profiler);
+void release_profiler(Profiler* profiler);
+
+//Nodes and functions sorted by exclusive time, at most limit rows each
+void write_profile(Profiler* profiler,OutputSink& out,size_t limit = 40);
+void write_folded_stacks(Profiler* profiler,OutputSink& out);
@@ -16,7 +16,7 @@ Expression* solve(Vector* v)
 
 #define internalConstants(o) \
     o(M_PI)
-void registerInternalFunctions()
+void registerInternalFunctions(Builtins& builtins)
 {
     internalFunctions(m_registerInternalFunction);
     internalSpecialFunctions(m_registerInternalSpecialFunction);
@@ -1,2 +1,3 @@
 #pragma once
-void registerInternalFunctions();
+struct Builtins;
+void registerInternalFunctions(Builtins& builtins);
@@ -0,0 +1,120 @@
+#include "render.h"
+#include "expression_types.h"
+
+const Value* RenderView::value(const Expression* expression) const
+{
+    if (table == nullptr) return expression->wasEvaluated ? &expression->lastEvaluatedValue : nullptr;
+    auto it = table->values.find(expression);
+    if (it == table->values.end() || it->second.step > limit) return nullptr;
+    return &it->second.value;
+}
+
+//Evaluates the nodes of one statement, a node stays pinned to its value until the statement is done so its parents reuse it
+struct StatementEvaluation
+{
+    Scope& scope;
+    RenderTable& table;
+    std::vector<Expression*> pinned;
+
+    StatementEvaluation(Scope& _scope,RenderTable& _table) : scope(_scope), table(_table) { }
+    ~StatementEvaluation() { for (Expression* e : pinned) e->pinned = false; }
+
+    void reveal(Expression* expression)
+    {
+        Value v = expression->evaluate(scope);
+        RenderTable::Entry& entry = table.values[expression];
+        entry.value = std::move(v);
+        entry.step = ++table.steps;
+        if (!expression->pinned)
+        {
+            expression->pinned = true;
+            pinned.push_back(expression);
+        }
+    }
+
+    //Post order, the derivation is printed again after every node but vector literals
+    void visit(Expression* current,std::vector<size_t>& steps)
+    {
+        for (Expression* c : current->dependencies)
+        {
+            if (current->getType() == ex_FunctionCall && c->getType() == ex_Variable) continue;
+            if (c->getType() == ex_Function || c->getType() == ex_Constant) continue;
+            visit(c,steps);
+        }
+        reveal(current);
+        if (current->getType() != ex_Vector) steps.push_back(table.steps);
+    }
+
+    void derive(Expression* expression)
+    {
+        std::vector<size_t> steps{table.steps};
+        visit(expression,steps);
+        table.derivations[expression] = std::move(steps);
+    }
+
+    //Same walk as the printers, assignments are derived when their value is final and then bound and forced
+    void collect(Expression* expression)
+    {
+        switch(expression->getType())
+        {
+            case ex_Assignment:
+            {
+                Assignment* assignment = static_cast<Assignment*>(expression);
+                if (assignment->assignment->is_final()) derive(assignment->assignment);
+                else collect(assignment->assignment);
+                reveal(assignment);
+                return;
+            }
+            //Bodies only have a value for some arguments
+            case ex_Function: return;
+            default:
+                for (Expression* e : expression->dependencies) collect(e);
+        }
+    }
+};
+
+void evaluate_statement(Scope& scope,RenderTable& table,Expression* statement)
+{
+    table.statements[statement] = table.steps;
+    StatementEvaluation evaluation(scope,table);
+    evaluation.collect(statement);
+}
+
+void render_statement(const RenderTable& table,Expression* statement,OutputSink& out)
+{
+    auto it = table.statements.find(statement);
+    statement->print(RenderView(&table,it == table.statements.end() ? table.steps : it->second),out);
+}
+
+void render_document(Scope& scope,OutputSink& out)
+{
+    Expression* root = scope.rootExpression;
+    if (root == nullptr) return;
+    std::vector<Expression*> statements;
+    if (root->getType() == ex_ExpressionBlock) statements = static_cast<ExpressionBlock*>(root)->expressions;
+    else statements.push_back(root);
+
+    FrameSwitch frame(scope,scope.global);
+    RenderTable table;
+    for (Expression* statement : statements) evaluate_statement(scope,table,statement);
+    for (size_t i = 0; i < statements.size(); i++)
+    {
+        render_statement(table,statements[i],out);
+        if (i + 1 != statements.size()) out += "\n";
+    }
+}
+
+void latexize(const RenderView& view,Expression* expression,OutputSink& str)
+{
+    if (view.table == nullptr || view.table->derivations.count(expression) == 0)
+    {
+        expression->print(view,str);
+        return;
+    }
+    const std::vector<size_t>& steps = view.table->derivations.at(expression);
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+        if (i) str += " = ";
+        expression->print(view.at(steps[i]),str);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "value.h"
+#include <unordered_map>
+#include <vector>
+
+struct Scope;
+struct Expression;
+struct OutputSink;
+
+/*
+    Rendering in two phases, printing never evaluates anything.
+    evaluate_statement() evaluates a top level statement in the order its derivations
+    reveal values, every node once, and records in a RenderTable the value of each node
+    and the step it was revealed at. The printers only read that table through a
+    RenderView: a step of a derivation shows the nodes revealed up to that step.
+*/
+struct RenderTable
+{
+    struct Entry
+    {
+        Value value;
+        size_t step;
+    };
+
+    std::unordered_map<const Expression*,Entry> values;
+    std::unordered_map<const Expression*,std::vector<size_t>> derivations;    //Steps an assigned expression is printed at, the first before any of it was revealed
+    std::unordered_map<const Expression*,size_t> statements;                 //Step each top level statement started at
+    size_t steps = 0;
+};
+
+//What the printers show for a node: its value in the table up to a step, or without a table the value the node holds
+struct RenderView
+{
+    const RenderTable* table = nullptr;
+    size_t limit = 0;
+
+    RenderView() { }
+    RenderView(const RenderTable* _table,size_t _limit) : table(_table), limit(_limit) { }
+
+    RenderView at(size_t step) const { return RenderView(table,step); }
+    const Value* value(const Expression* expression) const;
+};
+
+//Evaluation phase of a top level statement, in the current frame
+void evaluate_statement(Scope& scope,RenderTable& table,Expression* statement);
+
+//Printing phase of a statement evaluated into the table
+void render_statement(const RenderTable& table,Expression* statement,OutputSink& out);
+
+//Both phases for the whole document
+void render_document(Scope& scope,OutputSink& out);
+
+//Prints an assigned expression and every step of its derivation
+void latexize(const RenderView& view,Expression* expression,OutputSink& str);
@@ -0,0 +1,239 @@
+#include "resolver.h"
+#include "expression_types.h"
+
+/*
+    A function is pure when every name its body reaches outside of itself is a builtin
+    other than an expression builtin, or a document level name defined exactly once as a
+    constant or as another pure function. Names looked up dynamically (string
+    interpolation, unresolved variables) make the function impure.
+*/
+struct FunctionInfo
+{
+    Function* function;
+    size_t base;                        //Position of the body layout in the chain
+    bool impure = false;
+    std::vector<int> globals;           //Document level names the body depends on
+};
+
+struct Resolver
+{
+    Scope& scope;
+    std::vector<Layout*> chain;         //Innermost block last
+
+    std::vector<FunctionInfo> functions;
+    std::vector<size_t> open;           //Functions being resolved, innermost last
+    std::map<int,std::vector<Expression*>> definitions;     //Document level assignments
+
+    Resolver(Scope& _scope) : scope(_scope) { }
+
+    //Records a reference to the chain position found (-1 for builtins, -2 when unresolved)
+    void escape(const Variable* variable,int found)
+    {
+        for (size_t i : open)
+        {
+            FunctionInfo& info = functions[i];
+            if (found >= (int)info.base) continue;
+            if (found == 0) info.globals.push_back(variable->symbol);
+            else if (found == -1)
+            {
+                Expression* builtin = scope.builtins.slots[variable->slot].expression;
+                if (builtin->getType() == ex_InternalFunction && static_cast<InternalFunction*>(builtin)->is_expression_function()) info.impure = true;
+            }
+            else info.impure = true;
+        }
+    }
+
+    bool pure_definition(int symbol,const std::map<Function*,size_t>& index)
+    {
+        auto it = definitions.find(symbol);
+        if (it == definitions.end() || it->second.size() != 1) return false;
+        Expression* expression = it->second[0];
+        if (expression->getType() == ex_Function) return !functions[index.at(static_cast<Function*>(expression))].impure;
+        return expression->is_const();
+    }
+
+    //Greatest fixed point, so mutually recursive functions can be pure
+    void mark_pure_functions()
+    {
+        std::map<Function*,size_t> index;
+        for (size_t i = 0; i < functions.size(); i++) index[functions[i].function] = i;
+
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (FunctionInfo& info : functions)
+            {
+                if (info.impure) continue;
+                for (int symbol : info.globals)
+                {
+                    if (pure_definition(symbol,index)) continue;
+                    info.impure = changed = true;
+                    break;
+                }
+            }
+        }
+        for (FunctionInfo& info : functions)
+        {
+            info.function->is_pure = !info.impure;
+            if (info.function->is_pure) scope.pureFunctions.push_back(info.function);
+        }
+    }
+
+    static void declare(Layout& layout,const Variable* variable)
+    {
+        if (layout.count(variable->symbol) == 0)
+        {
+            int slot = layout.size();
+            layout[variable->symbol] = slot;
+        }
+    }
+
+    //Collects the assignments that define names in the block being resolved
+    void hoist(Expression* expression,Layout& layout)
+    {
+        switch(expression->getType())
+        {
+            case ex_Assignment:
+            {
+                Assignment* assignment = static_cast<Assignment*>(expression);
+                declare(layout,assignment->identifier);
+                hoist(assignment->assignment,layout);
+                break;
+            }
+            case ex_Vector:
+                for (Expression* e : static_cast<Vector*>(expression)->variables) hoist(e,layout);
+                break;
+            case ex_Operation:
+                hoist(static_cast<Operation*>(expression)->a,layout);
+                hoist(static_cast<Operation*>(expression)->b,layout);
+                break;
+            case ex_ReturnExpression:
+                hoist(static_cast<ReturnExpression*>(expression)->returnValue,layout);
+                break;
+            case ex_FunctionCall:
+                hoist(static_cast<FunctionCall*>(expression)->valueVector,layout);
+                break;
+            default: break;
+        }
+    }
+
+    void bind(Variable* variable)
+    {
+        variable->layout = chain.back();
+        int depth = 0;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it, ++depth)
+        {
+            auto found = (*it)->find(variable->symbol);
+            if (found != (*it)->end())
+            {
+                variable->depth = depth;
+                variable->slot = found->second;
+                escape(variable,chain.size() - 1 - depth);
+                return;
+            }
+        }
+        const Layout& builtins = *scope.builtins.layout;
+        auto found = builtins.find(variable->symbol);
+        if (found != builtins.end())
+        {
+            variable->depth = depth;
+            variable->slot = found->second;
+            escape(variable,-1);
+        }
+        else escape(variable,-2);
+    }
+
+    void resolve_block(ExpressionBlock* block)
+    {
+        for (Expression* e : block->expressions) hoist(e,block->layout);
+        chain.push_back(&block->layout);
+        for (Expression* e : block->expressions) resolve(e);
+        chain.pop_back();
+    }
+
+    void resolve(Expression* expression)
+    {
+        switch(expression->getType())
+        {
+            case ex_Variable:
+                bind(static_cast<Variable*>(expression));
+                break;
+            case ex_Assignment:
+            {
+                Assignment* assignment = static_cast<Assignment*>(expression);
+                bind(assignment->identifier);
+                if (chain.size() == 1) definitions[assignment->identifier->symbol].push_back(assignment->assignment);
+                if (assignment->assignment->getType() == ex_Function) static_cast<Function*>(assignment->assignment)->symbol = assignment->identifier->symbol;
+                resolve(assignment->assignment);
+                break;
+            }
+            case ex_Vector:
+                for (Expression* e : static_cast<Vector*>(expression)->variables) resolve(e);
+                break;
+            case ex_Operation:
+                resolve(static_cast<Operation*>(expression)->a);
+                resolve(static_cast<Operation*>(expression)->b);
+                break;
+            case ex_ReturnExpression:
+                resolve(static_cast<ReturnExpression*>(expression)->returnValue);
+                break;
+            case ex_ExpressionBlock:
+                resolve_block(static_cast<ExpressionBlock*>(expression));
+                break;
+            case ex_Function:
+            {
+                Function* function = static_cast<Function*>(expression);
+                Layout& layout = function->expressionBlock->layout;
+                open.push_back(functions.size());
+                functions.push_back({function,chain.size()});
+                for (Expression* parameter : function->parameterVector->variables) declare(layout,static_cast<Variable*>(parameter));
+                chain.push_back(&layout);
+                for (Expression* parameter : function->parameterVector->variables) bind(static_cast<Variable*>(parameter));
+                chain.pop_back();
+                resolve_block(function->expressionBlock);
+                open.pop_back();
+                break;
+            }
+            case ex_FunctionCall:
+            {
+                FunctionCall* call = static_cast<FunctionCall*>(expression);
+                bind(call->functionIdentifier);
+                if (call->functionIdentifier->depth == (int)chain.size())
+                {
+                    Expression* function = scope.builtins.slots[call->functionIdentifier->slot].expression;
+                    if (function->getType() == ex_InternalFunction) call->builtin = static_cast<InternalFunction*>(function);
+                }
+                resolve(call->valueVector);
+                break;
+            }
+            case ex_StringConstant:
+                for (size_t i : open) functions[i].impure = true;
+                for (const StringConstant::Segment& segment : static_cast<StringConstant*>(expression)->segments)
+                {
+                    if (segment.variable) bind(segment.variable);
+                }
+                break;
+            default: break;
+        }
+    }
+};
+
+const Layout* resolve_program(Expression* root,Scope& scope)
+{
+    Resolver resolver(scope);
+    if (root->getType() == ex_ExpressionBlock)
+    {
+        ExpressionBlock* block = static_cast<ExpressionBlock*>(root);
+        block->is_global = true;
+        resolver.resolve_block(block);
+        resolver.mark_pure_functions();
+        return &block->layout;
+    }
+
+    resolver.hoist(root,scope.rootLayout);
+    resolver.chain.push_back(&scope.rootLayout);
+    resolver.resolve(root);
+    resolver.mark_pure_functions();
+    return &scope.rootLayout;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include "scope.h"
+
+//Binds every Variable of the tree to a (depth, slot) pair using lexical scoping.
+//Each ExpressionBlock gets a Layout with the names it defines (parameters first),
+//returns the layout of the document itself.
+const Layout* resolve_program(Expression* root,Scope& scope);
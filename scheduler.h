@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Fork join pool with work stealing.
+    Every participant owns a deque of tasks: it takes work from the back of its own deque
+    and steals from the front of the others once it runs dry. run() spreads a batch over
+    the deques, the calling thread takes part in the work as participant 0 and returns
+    once the whole batch is done. Batches of several callers can be in flight at once,
+    so one pool serves every Scope of the process. Tasks must not throw.
+*/
+struct TaskScheduler
+{
+    using Task = std::function<void()>;
+
+    TaskScheduler(unsigned threads) : queues(threads < 1 ? 1 : threads)
+    {
+        for (size_t i = 1; i < queues.size(); i++) workers.emplace_back([this,i] { work(i); });
+    }
+    TaskScheduler(const TaskScheduler&) = delete;
+
+    ~TaskScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    size_t size() const { return queues.size(); }
+
+    //One pool for the whole process, sized by the first caller
+    static TaskScheduler& shared(unsigned threads)
+    {
+        static TaskScheduler pool(threads);
+        return pool;
+    }
+
+    void run(std::vector<Task>& tasks)
+    {
+        if (tasks.empty()) return;
+        std::atomic<size_t> pending{tasks.size()};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < tasks.size(); i++)
+            {
+                Queue& queue = queues[i % queues.size()];
+                std::lock_guard<std::mutex> queueLock(queue.mutex);
+                queue.tasks.push_back({&tasks[i],&pending});
+            }
+            queued += tasks.size();
+        }
+        wake.notify_all();
+
+        //Tasks of other batches may be taken meanwhile, they finish just the same
+        while (pending > 0)
+        {
+            if (Job job = take(0); job.task) { execute(job); continue; }
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock,[&pending] { return pending == 0; });
+        }
+    }
+
+    //True on a thread that is running a task, nested work is not handed out from there
+    static bool in_task() { return running(); }
+
+    private:
+
+    //A task and the count of unfinished tasks of its batch
+    struct Job
+    {
+        Task* task;
+        std::atomic<size_t>* pending;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> tasks;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;       //Workers waiting for a batch
+    std::condition_variable done;       //Caller waiting for the end of a batch
+    std::atomic<size_t> queued{0};
+    bool stop = false;
+
+    static bool& running()
+    {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    //Own deque first, newest task, then the oldest task of every other deque
+    Job take(size_t index)
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            Queue& queue = queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            Job job;
+            if (i == 0) { job = queue.tasks.back(); queue.tasks.pop_back(); }
+            else { job = queue.tasks.front(); queue.tasks.pop_front(); }
+            queued--;
+            return job;
+        }
+        return {nullptr,nullptr};
+    }
+
+    void execute(const Job& job)
+    {
+        bool nested = running();
+        running() = true;
+        (*job.task)();
+        running() = nested;
+        if (--*job.pending == 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+
+    void work(size_t index)
+    {
+        for (;;)
+        {
+            if (Job job = take(index); job.task) { execute(job); continue; }
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock,[this] { return stop || queued > 0; });
+            if (stop) return;
+        }
+    }
+};
@@ -1,48 +1,246 @@
 #include "scope.h"
 #include "expression.h"
-Scope::Scope() 
+#include "expression_types.h"
+#include "resolver.h"
+#include "optimizer.h"
+#include "bytecode.h"
+#include "register_types.h"
+#include "native.h"
+#include <unordered_map>
+#include <thread>
+
+int Symbols::find(std::string_view name) const
 {
-    currentScope = 0; 
-    variableStack.emplace_back(); 
+    if (shared)
+    {
+        int symbol = shared->find(name);
+        if (symbol >= 0) return symbol;
+    }
+    auto it = table.find(name);
+    return it != table.end() ? it->second : -1;
 }
 
-void Scope::operator ++()
+int Symbols::intern(std::string_view name)
 {
-    if (currentScope == variableStack.size() - 1) variableStack.emplace_back();
-    currentScope++;
-    variableStack[currentScope].clear();
+    int symbol = find(name);
+    if (symbol >= 0) return symbol;
+    names.emplace_back(name);
+    return table[names.back()] = first + names.size() - 1;
 }
 
-void Scope::operator --() { currentScope--; }
+const std::string& Symbols::name(int symbol) const
+{
+    if (symbol < first) return shared->name(symbol);
+    return names[symbol - first];
+}
 
-Expression* Scope::resolve(const string& name) 
-{ 
-    int i = currentScope;
-    while(i >= 0)
+Expression* Builtins::define(const string& name,Expression* expression)
+{
+    #ifdef DEBUG
+    cerr << "Builtins: Variable definition " << name << " as " << literalType(expression) << endl;
+    #endif
+    int symbol = symbols.intern(name);
+    if (layout.count(symbol) == 0)
     {
-        auto it = variableStack[i].find(name);
-        if (it != variableStack[i].end()) return it->second;
-        i--;
+        layout[symbol] = slots.size();
+        slots.emplace_back();
     }
-    
+    slots[layout[symbol]].expression = expression;
+    return expression;
+}
+
+const Builtins& Builtins::get()
+{
+    static const Builtins* builtins = []()
+    {
+        Builtins* table = new Builtins();
+        registerInternalFunctions(*table);
+        return table;
+    }();
+    return *builtins;
+}
+
+//EXPRESS_MEMO=<entries> enables the memo cache of pure functions
+static size_t default_memo_capacity()
+{
+    const char* entries = std::getenv("EXPRESS_MEMO");
+    return entries ? std::strtoul(entries,nullptr,10) : 0;
+}
+
+//EXPRESS_THREADS=<threads> sets the threads of parallel evaluation, every core by default
+static unsigned default_thread_count()
+{
+    const char* threads = std::getenv("EXPRESS_THREADS");
+    if (threads) return std::max(1ul,std::strtoul(threads,nullptr,10));
+    return std::max(1u,std::thread::hardware_concurrency());
+}
+
+//EXPRESS_CACHE=<directory> keeps the parsed documents read from files
+static std::string default_cache_directory()
+{
+    const char* directory = std::getenv("EXPRESS_CACHE");
+    return directory ? directory : "";
+}
+
+//EXPRESS_NATIVE=<directory> compiles the pure numeric functions of documents and keeps the objects there
+static std::string default_native_directory()
+{
+    const char* directory = std::getenv("EXPRESS_NATIVE");
+    return directory ? directory : "";
+}
+
+Scope::Scope() : symbols(&Builtins::get().symbols)
+{
+    memoCapacity = default_memo_capacity();
+    threads = default_thread_count();
+    cacheDirectory = default_cache_directory();
+    nativeDirectory = default_native_directory();
+    const Builtins& table = Builtins::get();
+    builtins.layout = &table.layout;
+    builtins.slots = table.slots;
+    builtins.parent = nullptr;
+    builtins.caller = nullptr;
+    builtins.level = 0;
+    current = &builtins;
+}
+
+Scope::~Scope()
+{
+    delete program;
+    release_native_module(native);
+    for (Frame* frame : frames) delete frame;
+}
+
+Frame* Scope::enter(const Layout* layout,Frame* parent)
+{
+    if (activeFrames == frames.size()) frames.push_back(new Frame());
+    Frame* frame = frames[activeFrames++];
+    frame->layout = layout;
+    frame->parent = parent;
+    frame->caller = current;
+    frame->level = parent->level + 1;
+    frame->slots.assign(layout->size(),Binding());
+    frame->dynamic.clear();
+    frame->common.clear();
+    return current = frame;
+}
+
+void Scope::leave(Frame* previous)
+{
+    activeFrames--;
+    current = previous;
+}
+
+Binding* Scope::lookup(const Variable* variable)
+{
+    Binding* binding = find_binding(variable);
+    if (binding) return binding;
+
+    cerr << "Variable " << variable->name << " not found in any scope" << endl;
+    throw std::runtime_error("Variable not found");
+}
+
+static Binding* bound_in(Frame* frame,int symbol)
+{
+    auto it = frame->layout->find(symbol);
+    if (it != frame->layout->end() && frame->slots[it->second].expression) return &frame->slots[it->second];
+    auto dyn = frame->dynamic.find(symbol);
+    return dyn != frame->dynamic.end() ? &dyn->second : nullptr;
+}
+
+//Lexically visible names come first. A function still sees the names of its callers that it
+//does not see lexically, documents written for the dynamic scoping of the first versions keep working
+Binding* Scope::find_binding(int symbol)
+{
+    for (Frame* frame = current; frame != nullptr; frame = frame->parent)
+    {
+        if (Binding* binding = bound_in(frame,symbol)) return binding;
+    }
+    for (Frame* frame = current->caller; frame != nullptr; frame = frame->caller)
+    {
+        if (Binding* binding = bound_in(frame,symbol)) return binding;
+    }
+    return nullptr;
+}
+
+Binding* Scope::find_binding(const Variable* variable)
+{
+    if (variable->slot >= 0 && variable->layout == current->layout)
+    {
+        Frame* frame = current;
+        for (int i = 0; i < variable->depth; i++) frame = frame->parent;
+        Binding& binding = frame->slots[variable->slot];
+        if (binding.expression) return &binding;
+    }
+    //Not bound yet or evaluated outside of its block
+    return find_binding(variable->symbol);
+}
+
+Expression* Scope::find(const string& name)
+{
+    Binding* binding = find_binding(symbols.intern(name));
+    return binding ? binding->expression : nullptr;
+}
+
+Expression* Scope::resolve(const string& name)
+{
+    Expression* expression = find(name);
+    if (expression) return expression;
+
     cerr << "Variable " << name << " not found in any scope" << endl;
     throw std::runtime_error("Variable not found");
 }
-Expression* Scope::define(const string& name,Expression* expression) 
-{ 
+Binding* Scope::define(const string& name,Expression* expression)
+{
+    #ifdef DEBUG
+    cerr << "Scope: " << current->level << " : Variable definition " << name << " as " << literalType(expression) << endl;
+    #endif
+    int symbol = symbols.intern(name);
+    auto it = current->layout->find(symbol);
+    Binding& binding = it != current->layout->end() ? current->slots[it->second] : current->dynamic[symbol];
+    epoch++;
+    binding = Binding();
+    binding.expression = expression;
+    binding.frame = current;
+    return &binding;
+}
+
+Binding* Scope::assign(const Variable* identifier,Expression* expression)
+{
+    if (identifier->layout != current->layout || identifier->slot < 0) return define(identifier->name,expression);
+
     #ifdef DEBUG
-    cerr << "Scope: " << currentScope << " : Variable definition " << name << " as " << literalType(expression) << endl;
+    cerr << "Scope: " << current->level << " : Variable definition " << identifier->name << " as " << literalType(expression) << endl;
     #endif
-    return variableStack[currentScope][name] = expression; 
+    Binding& binding = current->slots[identifier->slot];
+    epoch++;
+    binding = Binding();
+    binding.expression = expression;
+    binding.frame = current;
+    return &binding;
 }
 
 void Scope::set_root_expression(Expression* expression)
-{ 
-    rootExpression = expression; 
+{
+    rootExpression = expression;
+    const Layout* layout = resolve_program(expression,*this);
+    optimize_program(expression,layout,*this);
+    global = enter(layout,&builtins);
+    if (!nativeDirectory.empty()) native = compile_native(expression,*this);
 }
-Value Scope::evaluate() 
-{ 
-    return rootExpression->evaluate(); 
+Value Scope::evaluate()
+{
+    if (rootExpression == nullptr) throw std::runtime_error("No document to evaluate, it was not parsed");
+    if (mode == eval_tree)
+    {
+        eliminateCommon = true;
+        Value result = rootExpression->evaluate(*this);
+        eliminateCommon = false;
+        return result;
+    }
+
+    if (program == nullptr) program = new Program(compile_program(rootExpression,*this));
+    VirtualMachine vm(*program);
+    return vm.run();
 }
 
-Scope* Scope::scope = nullptr;
@@ -1,29 +1,145 @@
 #pragma once
 #include "global.h"
 #include "value.h"
+#include "arena.h"
 #include <vector>
 #include <map>
 #include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
 
 struct Expression;
+struct Variable;
+struct Program;
+struct Frame;
+struct Function;
+struct NativeModule;
+struct Profiler;
+
+enum EvaluationMode
+{
+    eval_tree,          //Reference tree walker
+    eval_bytecode
+};
+
+//Interned identifiers, every name in a document is reduced to a small integer.
+//The names of the builtins are interned once per process, the names of a document are
+//numbered after them in its Scope and are released with it.
+struct Symbols
+{
+    Symbols(const Symbols* _shared = nullptr) : shared(_shared), first(_shared ? _shared->first + _shared->names.size() : 0) { }
+    Symbols(const Symbols&) = delete;
+
+    int intern(std::string_view name);
+    const std::string& name(int symbol) const;
+
+    private:
+
+    int find(std::string_view name) const;
+
+    const Symbols* shared;              //Builtin names, never written to once they are registered
+    int first;                          //Symbol of names[0]
+    std::unordered_map<std::string_view,int> table;
+    std::deque<std::string> names;      //Keeps the names in place while it grows so the table can refer to them
+};
+
+//Symbol to slot map of a block, filled by the resolver
+using Layout = std::map<int,int>;
+
+//A thunk: the expression is forced on first use and its value kept while Scope::epoch is unchanged
+struct Binding
+{
+    Expression* expression = nullptr;
+    Frame* frame = nullptr;             //Frame the expression has to be evaluated in
+    Value value;
+    unsigned epoch = 0;                 //Epoch value was forced in, 0 when never forced
+};
+
+struct CommonValue
+{
+    Value value;
+    unsigned epoch = 0;                 //Scope epoch the value was computed in
+};
+
+struct Frame
+{
+    const Layout* layout;
+    Frame* parent;                      //Lexically enclosing frame
+    Frame* caller;                      //Frame that was current when it was entered
+    int level;
+    std::vector<Binding> slots;
+    std::map<int,Binding> dynamic;      //Definitions that are not part of the layout
+    std::vector<CommonValue> common;    //Common subexpressions of this activation, see optimizer.h
+};
+
+//Builtin functions and constants, registered once per process and shared by every Scope
+struct Builtins
+{
+    Symbols symbols;
+    Layout layout;
+    std::vector<Binding> slots;
+
+    Expression* define(const std::string& name,Expression* expression);
+
+    static const Builtins& get();
+};
+
+//Interpreter context of one document: its nodes, frames and evaluation state.
+//It is passed explicitly to parsing, evaluation and printing, so separate documents can
+//be used from separate threads; only the Builtins table is shared and it is read only.
 struct Scope
 {
-    static Scope* scope;
-    static void initialize_scope(Scope* _scope) { scope = _scope; }
+    Symbols symbols;                    //Names of the document, see Symbols
+    Expression* rootExpression = nullptr;
+    EvaluationMode mode = eval_tree;
+    Program* program = nullptr;
+    size_t memoCapacity;                //Entries cached per pure function, 0 disables memoization
+    std::vector<Function*> pureFunctions;   //Filled by the resolver
+    unsigned epoch = 1;                 //Bumped by every assignment
+    bool eliminateCommon = false;       //Common subexpressions are only shared outside of printing
+    unsigned threads;                   //Threads for parallel evaluation, 1 evaluates everything in order
+    double parallelCost = 16384;        //Estimated cost a piece of work needs before it is handed out
+    std::string cacheDirectory;         //parse_file() caches parsed documents there, empty disables it, see ast_cache.h
+    std::string nativeDirectory;        //Pure numeric functions are compiled to native code there, empty disables it, see native.h
+    NativeModule* native = nullptr;
+    Profiler* profiler = nullptr;       //Set while a profile is taken, see profile.h
+    std::string sourceName;             //File the document was parsed from, for reports
 
-    Expression* rootExpression;
-    std::vector<std::map<std::string,Expression*>> variableStack;
-    int currentScope;
+    Arena arena;                        //Owns every node of the document
+    Layout rootLayout;                  //Used when the document is not a block
+    Frame builtins;
+    Frame* global = nullptr;
+    Frame* current;
+
+    std::vector<Frame*> frames;         //Frame pool, reused between calls
+    size_t activeFrames = 0;
 
     Scope();
+    ~Scope();
+
+    Frame* enter(const Layout* layout,Frame* parent);
+    void leave(Frame* previous);
 
-    void operator ++();
-    void operator --();
+    Binding* lookup(const Variable* variable);
+    Binding* find_binding(int symbol);          //nullptr when the name is not bound, see scope.cc
+    Binding* find_binding(const Variable* variable);
 
+    Expression* find(const std::string& name);
     Expression* resolve(const std::string& name);
-    Expression* define(const std::string& name,Expression* expression);
+    Binding* define(const std::string& name,Expression* expression);
+    Binding* assign(const Variable* identifier,Expression* expression);
 
     void set_root_expression(Expression* expression);
 
     Value evaluate();
 };
+
+//Evaluates in the frame of a binding and restores the current one afterwards
+struct FrameSwitch
+{
+    Scope& scope;
+    Frame* previous;
+    FrameSwitch(Scope& _scope,Frame* frame) : scope(_scope), previous(_scope.current) { if (frame) scope.current = frame; }
+    ~FrameSwitch() { scope.current = previous; }
+};
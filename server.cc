@@ -0,0 +1,224 @@
+#include "server.h"
+#include "express.h"
+#include "ast_cache.h"
+#include "expression_types.h"
+#include <cstdio>
+#include <csignal>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static const size_t max_header = 256;
+static const size_t max_document = size_t(1) << 30;
+
+//Parsed documents by content hash, shared by every connection, the least recently used one is evicted first
+struct ProgramCache
+{
+    static const size_t capacity = 256;
+
+    using Entry = std::pair<uint64_t,std::string>;
+
+    bool find(uint64_t hash,std::string& tree)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(hash);
+        if (it == entries.end()) return false;
+        order.splice(order.begin(),order,it->second);
+        tree = it->second->second;
+        return true;
+    }
+
+    void insert(uint64_t hash,std::string tree)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.count(hash)) return;
+        if (order.size() == capacity)
+        {
+            entries.erase(order.back().first);
+            order.pop_back();
+        }
+        order.emplace_front(hash,std::move(tree));
+        entries[hash] = order.begin();
+    }
+
+    private:
+
+    std::mutex mutex;
+    std::list<Entry> order;
+    std::unordered_map<uint64_t,std::list<Entry>::iterator> entries;
+};
+
+static ProgramCache programs;
+
+//Builds the document in scope from the cache, or parses it and keeps it there
+static bool load(Scope& scope,const std::string& code)
+{
+    uint64_t hash = content_hash(code.data(),code.size());
+    std::string tree;
+    Expression* root = nullptr;
+    if (programs.find(hash,tree)) root = decode_ast(tree.data(),tree.size(),hash,code.size(),scope);
+    if (root == nullptr)
+    {
+        root = parse_tree(code,scope);
+        if (root == nullptr) return false;
+        programs.insert(hash,encode_ast(hash,code.size(),root));
+    }
+    scope.set_root_expression(root);
+    return true;
+}
+
+static bool respond(const std::string& command,const std::string& code,std::string& result)
+{
+    if (command != "latex" && command != "tree" && command != "vm")
+    {
+        result = "unknown command " + command;
+        return false;
+    }
+    try
+    {
+        //Connections are served in parallel, every document is evaluated on its own thread
+        Scope scope;
+        scope.threads = 1;
+        if (!load(scope,code))
+        {
+            result = "syntax error";
+            return false;
+        }
+        OutputSink out(result);
+        if (command == "latex") render_document(scope,out);
+        else
+        {
+            scope.mode = command == "vm" ? eval_bytecode : eval_tree;
+            out += scope.evaluate();
+        }
+        return true;
+    }
+    catch (const std::exception& e) { result = e.what(); }
+    catch (const std::exception* e) { result = e->what(); delete e; }
+    catch (...) { result = "evaluation failed"; }
+    return false;
+}
+
+//Buffered reads of header lines and bodies
+struct FrameReader
+{
+    int fd;
+    std::string buffer;
+    size_t position = 0;
+
+    FrameReader(int _fd) : fd(_fd) { }
+
+    //At least n unread bytes are buffered, false when the input ends first
+    bool fill(size_t n)
+    {
+        while (buffer.size() - position < n)
+        {
+            buffer.erase(0,position);
+            position = 0;
+            char chunk[65536];
+            ssize_t got = ::read(fd,chunk,sizeof(chunk));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            buffer.append(chunk,got);
+        }
+        return true;
+    }
+
+    bool line(std::string& text)
+    {
+        size_t end;
+        while ((end = buffer.find('\n',position)) == std::string::npos)
+        {
+            if (buffer.size() - position > max_header || !fill(buffer.size() - position + 1)) return false;
+        }
+        text.assign(buffer,position,end - position);
+        position = end + 1;
+        return true;
+    }
+
+    bool body(size_t size,std::string& text)
+    {
+        if (!fill(size)) return false;
+        text.assign(buffer,position,size);
+        position += size;
+        return true;
+    }
+};
+
+static void reply(OutputSink& out,bool ok,const std::string& body)
+{
+    out += ok ? "ok " : "error ";
+    out += std::to_string(body.size());
+    out += '\n';
+    out += body;
+    out.flush();
+}
+
+void serve(int input,int output)
+{
+    std::signal(SIGPIPE,SIG_IGN);
+    FrameReader reader(input);
+    OutputSink out(output);
+    std::string header,code,result;
+    while (reader.line(header))
+    {
+        char command[16];
+        unsigned long long size;
+        if (std::sscanf(header.c_str(),"%15s %llu",command,&size) != 2 || size > max_document)
+        {
+            //The next frame cannot be found anymore
+            reply(out,false,"malformed header");
+            return;
+        }
+        if (!reader.body(size,code)) return;
+        result.clear();
+        bool ok = respond(command,code,result);
+        reply(out,ok,result);
+    }
+}
+
+int serve_socket(const std::string& path)
+{
+    std::signal(SIGPIPE,SIG_IGN);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    std::memcpy(address.sun_path,path.c_str(),path.size() + 1);
+
+    //A socket left by an earlier server is replaced, any other file is kept
+    struct stat existing;
+    if (::lstat(path.c_str(),&existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode)) throw std::runtime_error("Not a socket, not replaced: " + path);
+        ::unlink(path.c_str());
+    }
+
+    int fd = ::socket(AF_UNIX,SOCK_STREAM | SOCK_CLOEXEC,0);
+    if (fd < 0) throw std::runtime_error("Cannot create a socket");
+    if (::bind(fd,reinterpret_cast<sockaddr*>(&address),sizeof(address)) != 0 || ::listen(fd,64) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on " + path);
+    }
+
+    for (;;)
+    {
+        int client = ::accept4(fd,nullptr,nullptr,SOCK_CLOEXEC);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        std::thread([client]
+        {
+            serve(client,client);
+            ::close(client);
+        }).detach();
+    }
+    ::close(fd);
+    return 1;
+}
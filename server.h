@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+
+/*
+    Long running mode of dist/expr. Documents arrive framed over a connection and the
+    responses go back framed in the same order, each one written as soon as it is done,
+    so a client can send a whole batch at once and read the results as they complete.
+    A frame is a header line followed by a body of the given number of bytes:
+        request:  latex|tree|vm <length>\n<document>
+        response: ok|error <length>\n<latex, value or message>
+    Builtins are registered once per process and parsed documents are kept in memory by
+    content hash, a document that is sent again is neither lexed nor parsed.
+*/
+
+//Answers the requests read from input on output until input ends
+void serve(int input,int output);
+
+//Accepts connections on a Unix socket and serves each one on its own thread
+int serve_socket(const std::string& path);
@@ -0,0 +1,24 @@
+#include "express.h"
+#include <cstdlib>
+#include <iostream>
+
+//Usage: rebind file name value
+//Prints the latex of the document, then again after name is bound to value, see IncrementalDocument
+int main(int argc,char** argv)
+{
+    if (argc != 4) return 1;
+    try
+    {
+        auto program = ExpressProgram::compile_file(argv[1]);
+        std::cout << program->render_latex() << "\n";
+        program->bind(argv[2],std::strtod(argv[3],nullptr));
+        std::cout << program->render_latex() << "\n";
+        std::cout << program->evaluate()[0] << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,125 +3,301 @@
 #include <iostream>
 #include <cmath>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <charconv>
+#include "value_kernels.h"
 using namespace std;
 
+static const size_t number_chars = 32;         //Enough for any formatted double
+
+//Same text as streaming the number with the default precision, without allocating
+inline size_t format_double(char* buffer,double v)
+{
+    return std::to_chars(buffer,buffer + number_chars,v,std::chars_format::general,6).ptr - buffer;
+}
 
 inline string double_to_string(double v)
 {
-    ostringstream s;
-    s << v;
-    return s.str();
+    char buffer[number_chars];
+    return string(buffer,format_double(buffer,v));
 }
-struct Value : public vector<double>
+
+//Bytes of the heap buffers values allocated on this thread, read by the profiler
+inline thread_local size_t valueAllocatedBytes = 0;
+
+enum ValueKind : unsigned char
 {
-    string str;
+    val_scalar,         //Single number stored inline
+    val_small,          //Up to inline_capacity numbers stored inline
+    val_heap,           //Numbers in a heap buffer
+    val_string
+};
 
-    Value(const std::string& _str) : str(_str) { }
-    Value(double value) { push_back(value); }
+/*
+    Tagged value: scalars and short vectors never allocate, longer vectors own a heap
+    buffer and strings own a heap std::string. A value of size 1 broadcasts to any size
+    through at() and operator[].
+*/
+struct Value
+{
+    static const unsigned inline_capacity = 4;
+
+    Value(const std::string& _str) : kind(val_string), count(0)
+    {
+        text = new std::string(_str);
+        valueAllocatedBytes += _str.size();
+    }
+    Value(double value) : kind(val_scalar), count(1) { small[0] = value; }
     Value() : Value(0.0) { }
 
-    Value(const std::initializer_list<double>& l) : vector<double>(l) { }
-    Value(const vector<double>& v) : vector<double>(v) { }
+    Value(const std::initializer_list<double>& l) : Value(l.begin(),l.size()) { }
+    Value(const vector<double>& v) : Value(v.data(),v.size()) { }
 
-    template <typename ... T>
-    Value(const T&& ... args) : vector<double>(args...) { }
+    Value(const double* values,size_t n) : kind(val_small), count(0)
+    {
+        reserve(n);
+        if (n) std::memcpy(data(),values,n * sizeof(double));
+        set_size(n);
+    }
+
+    //Value without elements, functions evaluate to it and it prints as ()
+    static Value empty_vector() { return Value(nullptr,0); }
+
+    Value(const Value& other) : kind(val_small), count(0) { copy(other); }
+    Value(Value&& other) noexcept : kind(other.kind), count(other.count)
+    {
+        std::memcpy(small,other.small,sizeof(small));
+        other.release();
+    }
 
-    bool is_numeric() const { return size() == 1; }
+    ~Value() { destroy(); }
+
+    Value& operator=(const Value& other)
+    {
+        if (this != &other) { destroy(); kind = val_small; count = 0; copy(other); }
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept
+    {
+        if (this == &other) return *this;
+        destroy();
+        kind = other.kind; count = other.count;
+        std::memcpy(small,other.small,sizeof(small));
+        other.release();
+        return *this;
+    }
+
+    ValueKind get_kind() const { return kind; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    double* data() { return kind == val_heap ? heap.values : small; }
+    const double* data() const { return kind == val_heap ? heap.values : small; }
+
+    double* begin() { return data(); }
+    double* end() { return data() + count; }
+    const double* begin() const { return data(); }
+    const double* end() const { return data() + count; }
+
+    bool is_numeric() const { return count == 1; }
 
     double& at(size_t i)
     {
-        if (is_numeric()) return vector<double>::at(0);
-        else return vector<double>::at(i);
+        if (is_numeric()) return data()[0];
+        else return data()[i];
     }
 
     const double& operator[](const size_t i) const
     {
-        vector<double>& c = *((vector<double>*)this);
-        if (is_numeric()) return c[0];
-        else return c[i];
+        if (is_numeric()) return data()[0];
+        else return data()[i];
     }
 
     double& operator[](const size_t i) { return at(i); }
 
-    bool is_string() const { return !str.empty(); }
+    void reserve(size_t n)
+    {
+        if (kind == val_string) { delete text; kind = val_small; count = 0; }
+        if (n <= capacity()) return;
+
+        size_t newCapacity = std::max<size_t>(n,capacity() * 2);
+        double* values = new double[newCapacity];
+        valueAllocatedBytes += newCapacity * sizeof(double);
+        if (count) std::memcpy(values,data(),count * sizeof(double));
+        if (kind == val_heap) delete[] heap.values;
+        heap.values = values;
+        heap.capacity = newCapacity;
+        kind = val_heap;
+    }
+
+    void resize(size_t n,double fill = 0.0)
+    {
+        reserve(n);
+        double* values = data();
+        for (size_t i = count; i < n; i++) values[i] = fill;
+        set_size(n);
+    }
+
+    //Like resize but the new elements are left for the caller to write
+    void resize_for_overwrite(size_t n)
+    {
+        reserve(n);
+        set_size(n);
+    }
+
+    void push_back(double v)
+    {
+        if (count == capacity()) reserve(count + 1);
+        data()[count] = v;
+        set_size(count + 1);
+    }
+
+    void clear() { resize(0); }
 
-    string as_string() const { return str; }
+    bool is_string() const { return kind == val_string && !text->empty(); }
+
+    string as_string() const { return kind == val_string ? *text : string(); }
 
     operator string() const
-    { 
-        if (is_string()) return str;
+    {
         string result;
-        if (is_numeric()) result += double_to_string((*this)[0]);
-        else
+        format(result);
+        return result;
+    }
+
+    //Appends the printed value to anything with an append(const char*,size_t), see output_sink.h
+    template <typename Output>
+    void format(Output& out) const
+    {
+        if (is_string()) { out.append(text->data(),text->size()); return; }
+        char buffer[number_chars];
+        if (is_numeric()) { out.append(buffer,format_double(buffer,(*this)[0])); return; }
+        out.append("(",1);
+        for (size_t i = 0; i < size(); i++)
         {
-            result += "(";
-            for (size_t i = 0; i < size(); i++)
-            {
-                result += double_to_string((*this)[i]);
-                if (i < size() - 1) result += ", ";
-            }
-            result += ")";
+            out.append(buffer,format_double(buffer,(*this)[i]));
+            if (i < size() - 1) out.append(", ",2);
         }
-        return result;
+        out.append(")",1);
+    }
+
+    inline bool is_vector() const { return !is_string() && size() > 1; }
+
+    bool operator==(const Value& other) const
+    {
+        if (is_string() || other.is_string()) return as_string() == other.as_string();
+        return count == other.count && std::equal(begin(),end(),other.begin());
+    }
+    bool operator!=(const Value& other) const { return !(*this == other); }
+
+    private:
+
+    ValueKind kind;
+    unsigned count;
+    union
+    {
+        double small[inline_capacity];
+        struct { double* values; size_t capacity; } heap;
+        std::string* text;
+    };
+
+    size_t capacity() const { return kind == val_heap ? heap.capacity : (kind == val_string ? 0 : inline_capacity); }
+
+    void set_size(size_t n)
+    {
+        count = n;
+        if (kind != val_heap) kind = n == 1 ? val_scalar : val_small;
+    }
+
+    void copy(const Value& other)
+    {
+        if (other.kind == val_string)
+        {
+            kind = val_string;
+            text = new std::string(*other.text);
+            valueAllocatedBytes += text->size();
+            return;
+        }
+        reserve(other.count);
+        if (other.count) std::memcpy(data(),other.data(),other.count * sizeof(double));
+        set_size(other.count);
     }
 
-    inline bool is_vector() const { return !is_string() && size() > 1; } 
+    void destroy()
+    {
+        if (kind == val_heap) delete[] heap.values;
+        else if (kind == val_string) delete text;
+    }
+
+    //Forgets the owned buffer after it has been moved away
+    void release() { kind = val_small; count = 0; }
 };
 
-#define MASTER_OPERATOR(op,op2) \
+//A scalar broadcasts to the size of the other operand, otherwise the right operand has to be as long as the left one
+inline void check_broadcast(const Value& v,const Value& other)
+{
+    if (!v.is_numeric() && !other.is_numeric() && other.size() < v.size()) throw std::runtime_error("Vector sizes do not match");
+}
+
+inline double scalar_add(double a,double b) { return a + b; }
+inline double scalar_sub(double a,double b) { return a - b; }
+inline double scalar_mul(double a,double b) { return a * b; }
+inline double scalar_div(double a,double b) { return a / b; }
+inline double scalar_pow(double a,double b) { return std::pow(a,b); }
+
+#define MASTER_OPERATOR(op,op2,kernel) \
 inline Value& operator op2 (Value& v,const Value& other) \
 { \
-    if (v.is_numeric()) v.resize(other.size(),v[0]); \
-    for (size_t i = 0; i < v.size(); ++i) v[i] op2 other[i]; \
+    if (v.is_numeric() && other.is_numeric()) { v.data()[0] = scalar_##kernel(v[0],other[0]); return v; } \
+    const ValueKernels& k = value_kernels(); \
+    check_broadcast(v,other); \
+    if (v.is_numeric()) \
+    { \
+        double a = v[0]; \
+        v.resize_for_overwrite(other.size()); \
+        k.kernel##_sv(v.data(),a,other.data(),v.size()); \
+    } \
+    else if (other.is_numeric()) k.kernel##_vs(v.data(),v.data(),other[0],v.size()); \
+    else k.kernel##_vv(v.data(),v.data(),other.data(),v.size()); \
     return v; \
 } \
 inline Value operator op (const Value& v,const Value& other) \
 { \
-    Value result = v; \
-    result op2 other; \
+    if (v.is_numeric() && other.is_numeric()) return scalar_##kernel(v[0],other[0]); \
+    const ValueKernels& k = value_kernels(); \
+    check_broadcast(v,other); \
+    Value result; \
+    if (v.is_numeric()) \
+    { \
+        result.resize_for_overwrite(other.size()); \
+        k.kernel##_sv(result.data(),v[0],other.data(),result.size()); \
+    } \
+    else \
+    { \
+        result.resize_for_overwrite(v.size()); \
+        if (other.is_numeric()) k.kernel##_vs(result.data(),v.data(),other[0],result.size()); \
+        else k.kernel##_vv(result.data(),v.data(),other.data(),result.size()); \
+    } \
     return result; \
 }
 
-MASTER_OPERATOR(+,+=)
-MASTER_OPERATOR(-,-=)
-MASTER_OPERATOR(/,/=)
-MASTER_OPERATOR(*,*=)
+MASTER_OPERATOR(+,+=,add)
+MASTER_OPERATOR(-,-=,sub)
+MASTER_OPERATOR(/,/=,div)
+MASTER_OPERATOR(*,*=,mul)
+MASTER_OPERATOR(^,^=,pow)
 
 #undef MASTER_OPERATOR
 
-//Verbatim for ^ operator
-inline Value& operator ^= (Value& v,const Value& other)
-{
-    if (v.is_numeric()) v.resize(other.size(),v[0]);
-    for (size_t i = 0; i < v.size(); ++i) v[i] = pow(v[i],other[i]);
-    return v;
-}
-inline Value operator ^ (const Value& v,const Value& other)
-{
-    Value result = v;
-    result ^= other;
-    return result;
-}
-
-
 inline std::ostream& operator<<(std::ostream& os,const Value& v)
 {
     os << string(v);
     return os;
 }
 
-inline double vsum(Value v)
-{
-    double result = v[0];
-    for (size_t i = 1; i < v.size();i++) result += v[i];
-
-    return result;
-}
-
-inline double vprod(Value v)
-{
-    double result = v[0];
-    for (size_t i = 1; i < v.size();i++) result *= v[i];
+inline double vsum(const Value& v) { return value_kernels().sum(v.data(),v.size()); }
 
-    return result;
-}
+inline double vprod(const Value& v) { return value_kernels().prod(v.data(),v.size()); }
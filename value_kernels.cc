@@ -0,0 +1,233 @@
+#include "value_kernels.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EXPRESS_X86
+#endif
+
+//Powers are libm's in every implementation and for every shape of the operands
+static void pow_vv_libm(double* out,const double* a,const double* b,size_t n) { for (size_t i = 0; i < n; i++) out[i] = std::pow(a[i],b[i]); }
+static void pow_sv_libm(double* out,double a,const double* b,size_t n) { for (size_t i = 0; i < n; i++) out[i] = std::pow(a,b[i]); }
+static void pow_vs_libm(double* out,const double* a,double b,size_t n) { for (size_t i = 0; i < n; i++) out[i] = std::pow(a[i],b); }
+
+//Portable implementation
+
+#define PORTABLE_KERNELS(name,op) \
+static void name##_vv_portable(double* out,const double* a,const double* b,size_t n) { for (size_t i = 0; i < n; i++) out[i] = a[i] op b[i]; } \
+static void name##_vs_portable(double* out,const double* a,double b,size_t n) { for (size_t i = 0; i < n; i++) out[i] = a[i] op b; } \
+static void name##_sv_portable(double* out,double a,const double* b,size_t n) { for (size_t i = 0; i < n; i++) out[i] = a op b[i]; }
+
+PORTABLE_KERNELS(add,+)
+PORTABLE_KERNELS(sub,-)
+PORTABLE_KERNELS(mul,*)
+PORTABLE_KERNELS(div,/)
+
+#undef PORTABLE_KERNELS
+
+
+//Reductions keep 8 partial results, lanes[j] accumulates the elements with index j modulo 8
+
+#define PORTABLE_LANES(name,op) \
+static void name##_lanes_portable(double* lanes,const double* a,size_t n) \
+{ \
+    for (size_t i = 0; i + 8 <= n; i += 8) for (int j = 0; j < 8; j++) lanes[j] = lanes[j] op a[i + j]; \
+}
+
+PORTABLE_LANES(sum,+)
+PORTABLE_LANES(prod,*)
+
+#undef PORTABLE_LANES
+
+#define REDUCTION(name,op,identity,isa) \
+static double name##_##isa(const double* a,size_t n) \
+{ \
+    if (n == 0) return identity; \
+    if (n < 8) \
+    { \
+        double result = a[0]; \
+        for (size_t i = 1; i < n; i++) result = result op a[i]; \
+        return result; \
+    } \
+    double lanes[8]; \
+    for (int j = 0; j < 8; j++) lanes[j] = a[j]; \
+    size_t body = (n - 8) & ~size_t(7); \
+    name##_lanes_##isa(lanes,a + 8,body); \
+    double result = combine_##name(lanes); \
+    for (size_t i = 8 + body; i < n; i++) result = result op a[i]; \
+    return result; \
+}
+
+REDUCTION(sum,+,0.0,portable)
+REDUCTION(prod,*,1.0,portable)
+
+static const ValueKernels portableKernels = {
+    "portable",
+    add_vv_portable, sub_vv_portable, mul_vv_portable, div_vv_portable, pow_vv_libm,
+    add_vs_portable, sub_vs_portable, mul_vs_portable, div_vs_portable, pow_vs_libm,
+    add_sv_portable, sub_sv_portable, mul_sv_portable, div_sv_portable, pow_sv_libm,
+    sum_portable, prod_portable,
+    sum_lanes_portable, prod_lanes_portable
+};
+
+#ifdef EXPRESS_X86
+
+//SSE2, two lanes
+
+#define SSE2_KERNELS(name,op,intrinsic) \
+__attribute__((target("sse2"))) static void name##_vv_sse2(double* out,const double* a,const double* b,size_t n) \
+{ \
+    size_t i = 0; \
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i,intrinsic(_mm_loadu_pd(a + i),_mm_loadu_pd(b + i))); \
+    for (; i < n; i++) out[i] = a[i] op b[i]; \
+} \
+__attribute__((target("sse2"))) static void name##_vs_sse2(double* out,const double* a,double b,size_t n) \
+{ \
+    size_t i = 0; \
+    __m128d vb = _mm_set1_pd(b); \
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i,intrinsic(_mm_loadu_pd(a + i),vb)); \
+    for (; i < n; i++) out[i] = a[i] op b; \
+} \
+__attribute__((target("sse2"))) static void name##_sv_sse2(double* out,double a,const double* b,size_t n) \
+{ \
+    size_t i = 0; \
+    __m128d va = _mm_set1_pd(a); \
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i,intrinsic(va,_mm_loadu_pd(b + i))); \
+    for (; i < n; i++) out[i] = a op b[i]; \
+}
+
+SSE2_KERNELS(add,+,_mm_add_pd)
+SSE2_KERNELS(sub,-,_mm_sub_pd)
+SSE2_KERNELS(mul,*,_mm_mul_pd)
+SSE2_KERNELS(div,/,_mm_div_pd)
+
+#undef SSE2_KERNELS
+
+
+#define SSE2_LANES(name,intrinsic) \
+__attribute__((target("sse2"))) static void name##_lanes_sse2(double* lanes,const double* a,size_t n) \
+{ \
+    __m128d q0 = _mm_loadu_pd(lanes), q1 = _mm_loadu_pd(lanes + 2), q2 = _mm_loadu_pd(lanes + 4), q3 = _mm_loadu_pd(lanes + 6); \
+    for (size_t i = 0; i + 8 <= n; i += 8) \
+    { \
+        q0 = intrinsic(q0,_mm_loadu_pd(a + i)); \
+        q1 = intrinsic(q1,_mm_loadu_pd(a + i + 2)); \
+        q2 = intrinsic(q2,_mm_loadu_pd(a + i + 4)); \
+        q3 = intrinsic(q3,_mm_loadu_pd(a + i + 6)); \
+    } \
+    _mm_storeu_pd(lanes,q0); _mm_storeu_pd(lanes + 2,q1); _mm_storeu_pd(lanes + 4,q2); _mm_storeu_pd(lanes + 6,q3); \
+}
+
+SSE2_LANES(sum,_mm_add_pd)
+SSE2_LANES(prod,_mm_mul_pd)
+
+#undef SSE2_LANES
+
+REDUCTION(sum,+,0.0,sse2)
+REDUCTION(prod,*,1.0,sse2)
+
+static const ValueKernels sse2Kernels = {
+    "sse2",
+    add_vv_sse2, sub_vv_sse2, mul_vv_sse2, div_vv_sse2, pow_vv_libm,
+    add_vs_sse2, sub_vs_sse2, mul_vs_sse2, div_vs_sse2, pow_vs_libm,
+    add_sv_sse2, sub_sv_sse2, mul_sv_sse2, div_sv_sse2, pow_sv_libm,
+    sum_sse2, prod_sse2,
+    sum_lanes_sse2, prod_lanes_sse2
+};
+
+//AVX2, four lanes unrolled twice
+
+#define AVX2_KERNELS(name,op,intrinsic) \
+__attribute__((target("avx2"))) static void name##_vv_avx2(double* out,const double* a,const double* b,size_t n) \
+{ \
+    size_t i = 0; \
+    for (; i + 8 <= n; i += 8) \
+    { \
+        _mm256_storeu_pd(out + i,intrinsic(_mm256_loadu_pd(a + i),_mm256_loadu_pd(b + i))); \
+        _mm256_storeu_pd(out + i + 4,intrinsic(_mm256_loadu_pd(a + i + 4),_mm256_loadu_pd(b + i + 4))); \
+    } \
+    for (; i < n; i++) out[i] = a[i] op b[i]; \
+} \
+__attribute__((target("avx2"))) static void name##_vs_avx2(double* out,const double* a,double b,size_t n) \
+{ \
+    size_t i = 0; \
+    __m256d vb = _mm256_set1_pd(b); \
+    for (; i + 8 <= n; i += 8) \
+    { \
+        _mm256_storeu_pd(out + i,intrinsic(_mm256_loadu_pd(a + i),vb)); \
+        _mm256_storeu_pd(out + i + 4,intrinsic(_mm256_loadu_pd(a + i + 4),vb)); \
+    } \
+    for (; i < n; i++) out[i] = a[i] op b; \
+} \
+__attribute__((target("avx2"))) static void name##_sv_avx2(double* out,double a,const double* b,size_t n) \
+{ \
+    size_t i = 0; \
+    __m256d va = _mm256_set1_pd(a); \
+    for (; i + 8 <= n; i += 8) \
+    { \
+        _mm256_storeu_pd(out + i,intrinsic(va,_mm256_loadu_pd(b + i))); \
+        _mm256_storeu_pd(out + i + 4,intrinsic(va,_mm256_loadu_pd(b + i + 4))); \
+    } \
+    for (; i < n; i++) out[i] = a op b[i]; \
+}
+
+AVX2_KERNELS(add,+,_mm256_add_pd)
+AVX2_KERNELS(sub,-,_mm256_sub_pd)
+AVX2_KERNELS(mul,*,_mm256_mul_pd)
+AVX2_KERNELS(div,/,_mm256_div_pd)
+
+#undef AVX2_KERNELS
+
+
+#define AVX2_LANES(name,intrinsic) \
+__attribute__((target("avx2"))) static void name##_lanes_avx2(double* lanes,const double* a,size_t n) \
+{ \
+    __m256d lo = _mm256_loadu_pd(lanes), hi = _mm256_loadu_pd(lanes + 4); \
+    for (size_t i = 0; i + 8 <= n; i += 8) \
+    { \
+        lo = intrinsic(lo,_mm256_loadu_pd(a + i)); \
+        hi = intrinsic(hi,_mm256_loadu_pd(a + i + 4)); \
+    } \
+    _mm256_storeu_pd(lanes,lo); _mm256_storeu_pd(lanes + 4,hi); \
+}
+
+AVX2_LANES(sum,_mm256_add_pd)
+AVX2_LANES(prod,_mm256_mul_pd)
+
+#undef AVX2_LANES
+
+REDUCTION(sum,+,0.0,avx2)
+REDUCTION(prod,*,1.0,avx2)
+
+static const ValueKernels avx2Kernels = {
+    "avx2",
+    add_vv_avx2, sub_vv_avx2, mul_vv_avx2, div_vv_avx2, pow_vv_libm,
+    add_vs_avx2, sub_vs_avx2, mul_vs_avx2, div_vs_avx2, pow_vs_libm,
+    add_sv_avx2, sub_sv_avx2, mul_sv_avx2, div_sv_avx2, pow_sv_libm,
+    sum_avx2, prod_avx2,
+    sum_lanes_avx2, prod_lanes_avx2
+};
+
+#endif
+
+#undef REDUCTION
+
+static const ValueKernels& select_kernels()
+{
+    const char* forced = std::getenv("EXPRESS_SIMD");
+    if (forced && std::strcmp(forced,"scalar") == 0) return portableKernels;
+#ifdef EXPRESS_X86
+    __builtin_cpu_init();
+    bool allowAvx2 = !forced || std::strcmp(forced,"avx2") == 0;
+    if (allowAvx2 && __builtin_cpu_supports("avx2")) return avx2Kernels;
+    if (__builtin_cpu_supports("sse2")) return sse2Kernels;
+#endif
+    return portableKernels;
+}
+
+const ValueKernels& value_kernels()
+{
+    static const ValueKernels& kernels = select_kernels();
+    return kernels;
+}
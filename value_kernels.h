@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+
+/*
+    Element wise kernels used by Value arithmetic. The best implementation for the running
+    cpu (avx2, sse2 or portable) is selected on first use, EXPRESS_SIMD=scalar|sse2|avx2
+    overrides the choice. Every implementation produces bit identical results: reductions
+    always use 8 partial accumulators combined in the same order.
+*/
+struct ValueKernels
+{
+    using binaryKernel = void (*) (double* out,const double* a,const double* b,size_t n);
+    using vectorScalarKernel = void (*) (double* out,const double* a,double b,size_t n);
+    using scalarVectorKernel = void (*) (double* out,double a,const double* b,size_t n);
+    using reductionKernel = double (*) (const double* a,size_t n);
+    //Folds n (a multiple of 8) elements into 8 partial results, see combine_sum
+    using laneKernel = void (*) (double* lanes,const double* a,size_t n);
+
+    const char* name;
+
+    binaryKernel add_vv, sub_vv, mul_vv, div_vv, pow_vv;
+    vectorScalarKernel add_vs, sub_vs, mul_vs, div_vs, pow_vs;
+    scalarVectorKernel add_sv, sub_sv, mul_sv, div_sv, pow_sv;
+
+    reductionKernel sum, prod;
+    laneKernel sum_lanes, prod_lanes;
+};
+
+const ValueKernels& value_kernels();
+
+//Final step of a reduction over 8 partial results, shared by every implementation
+inline double combine_sum(double* lanes) { for (int j = 0; j < 4; j++) lanes[j] += lanes[j + 4]; return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]); }
+inline double combine_prod(double* lanes) { for (int j = 0; j < 4; j++) lanes[j] *= lanes[j + 4]; return (lanes[0] * lanes[1]) * (lanes[2] * lanes[3]); }